@@ -156,14 +156,12 @@ static void glava_start(void* data) {
     /* Obtain GLava's texture handle */
     blog(LOG_INFO, "Waiting for GLava GL texture...");
     glava_wait(&handle);
-    unsigned int g_tex = glava_tex(handle);
     glava_sizereq(handle, 0, 0, s->cfg.w, s->cfg.h);
     obs_enter_graphics();
-    /* Create a new high-level texture object */
+    /* Create a new high-level texture object; its internal GL texture is replaced with the
+       latest GLava frame each time it is drawn */
     s->gs_tex = gs_texture_create(s->cfg.w, s->cfg.h, GS_RGBA, 1, NULL, GS_DYNAMIC);
-    /* Re-assign the internal GL texture for the object */
     s->old_tex = ((struct gs_texture_2d_internal*) s->gs_tex)->base.texture;
-    ((struct gs_texture_2d_internal*) s->gs_tex)->base.texture = g_tex;
     obs_leave_graphics();
     blog(LOG_INFO, "GLava texture assigned");
 }
@@ -207,10 +205,17 @@ static void video_render(void* data, gs_effect_t* effect) {
 
     effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 
+    /* Re-assign the internal GL texture for the object to the latest complete frame. The
+       texture unit is cleared first, since bindings are only updated when the object changes. */
+    gs_load_texture(NULL, 0);
+    ((struct gs_texture_2d_internal*) s->gs_tex)->base.texture = glava_acquire(handle, NULL);
+
     gs_eparam_t* img = gs_effect_get_param_by_name(effect, "image");
     gs_effect_set_texture(img, s->gs_tex);
     while (gs_effect_loop(effect, "Draw"))
         obs_source_draw(s->gs_tex, 0, 0, 0, 0, true);
+
+    glava_release(handle);
 }
 
 static void* create(obs_data_t* settings, obs_source_t* source) {
@@ -0,0 +1,293 @@
+/* Headless EGL context creation backend */
+
+#ifdef GLAVA_EGL
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <dlfcn.h>
+
+#include "glad.h"
+
+#include "render.h"
+
+/* EGL is loaded at runtime (like libGL for the GLX backend), so only the subset of
+   `EGL/egl.h` and `EGL/eglext.h` used here is declared. */
+
+typedef void*        EGLDisplay;
+typedef void*        EGLConfig;
+typedef void*        EGLContext;
+typedef void*        EGLSurface;
+typedef void*        EGLNativeDisplayType;
+typedef int32_t      EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define EGL_DEFAULT_DISPLAY                 ((EGLNativeDisplayType) 0)
+#define EGL_NO_DISPLAY                      ((EGLDisplay) 0)
+#define EGL_NO_CONTEXT                      ((EGLContext) 0)
+#define EGL_NO_SURFACE                      ((EGLSurface) 0)
+
+#define EGL_ALPHA_SIZE                      0x3021
+#define EGL_BLUE_SIZE                       0x3022
+#define EGL_GREEN_SIZE                      0x3023
+#define EGL_RED_SIZE                        0x3024
+#define EGL_SURFACE_TYPE                    0x3033
+#define EGL_NONE                            0x3038
+#define EGL_RENDERABLE_TYPE                 0x3040
+#define EGL_EXTENSIONS                      0x3055
+#define EGL_HEIGHT                          0x3056
+#define EGL_WIDTH                           0x3057
+#define EGL_OPENGL_API                      0x30A2
+#define EGL_PBUFFER_BIT                     0x0001
+#define EGL_OPENGL_BIT                      0x0008
+
+/* EGL 1.5 or EGL_KHR_create_context */
+#define EGL_CONTEXT_MAJOR_VERSION           0x3098
+#define EGL_CONTEXT_MINOR_VERSION           0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK     0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x00000001
+
+/* EGL_MESA_platform_surfaceless */
+#define EGL_PLATFORM_SURFACELESS_MESA       0x31DD
+
+typedef void       (*__eglMustCastToProperFunctionPointerType)(void);
+typedef EGLDisplay (*eglGetPlatformDisplayEXTProc)(EGLenum platform, void* native_display,
+                                                   const EGLint* attrib_list);
+
+__eglMustCastToProperFunctionPointerType
+                (*eglGetProcAddress)      (const char* procname);
+const char*     (*eglQueryString)         (EGLDisplay dpy, EGLint name);
+EGLint          (*eglGetError)            (void);
+EGLDisplay      (*eglGetDisplay)          (EGLNativeDisplayType display_id);
+EGLBoolean      (*eglInitialize)          (EGLDisplay dpy, EGLint* major, EGLint* minor);
+EGLBoolean      (*eglTerminate)           (EGLDisplay dpy);
+EGLBoolean      (*eglBindAPI)             (EGLenum api);
+EGLBoolean      (*eglChooseConfig)        (EGLDisplay dpy, const EGLint* attrib_list,
+                                           EGLConfig* configs, EGLint config_size,
+                                           EGLint* num_config);
+EGLContext      (*eglCreateContext)       (EGLDisplay dpy, EGLConfig config,
+                                           EGLContext share_context, const EGLint* attrib_list);
+EGLBoolean      (*eglDestroyContext)      (EGLDisplay dpy, EGLContext ctx);
+EGLSurface      (*eglCreatePbufferSurface)(EGLDisplay dpy, EGLConfig config,
+                                           const EGLint* attrib_list);
+EGLBoolean      (*eglDestroySurface)      (EGLDisplay dpy, EGLSurface surface);
+EGLBoolean      (*eglMakeCurrent)         (EGLDisplay dpy, EGLSurface draw,
+                                           EGLSurface read, EGLContext ctx);
+
+extern struct gl_wcb wcb_egl;
+
+static void*      hegl;
+static EGLDisplay display;
+static bool       surfaceless; /* contexts can be made current without a surface */
+
+/* There is no window; the renderer always draws into its own framebuffer (`off_sfbo`) and
+   the context is only ever bound to a surface if the driver requires one. */
+struct eglwin {
+    EGLContext context;
+    EGLSurface surface; /* 1x1 pbuffer, or `EGL_NO_SURFACE` if `surfaceless` */
+    int w, h;
+    double time;
+};
+
+static bool offscreen(void) { return true; }
+
+static void* resolve_f(const char* symbol, void* egl) {
+    void* s = NULL;
+    if (egl) s = dlsym(egl, symbol);
+    if (!s) {
+        fprintf(stderr, "Failed to resolve EGL symbol: `%s`\n", symbol);
+        glava_abort();
+    }
+    return s;
+}
+
+static void init(void) {
+    static const char *dl_names[] = {"libEGL.so.1", "libEGL.so"};
+
+    for (size_t i = 0; i < (sizeof(dl_names) / sizeof(dl_names[0])) && hegl == NULL; ++i)
+        hegl = dlopen(dl_names[i], RTLD_LAZY);
+
+    if (!hegl) {
+        fprintf(stderr, "Failed to load EGL functions (libEGL does not exist!)\n");
+        glava_abort();
+    }
+
+    #define resolve(name) do { name = (typeof(name)) resolve_f(#name, hegl); } while (0)
+
+    resolve(eglGetProcAddress);
+    resolve(eglQueryString);
+    resolve(eglGetError);
+    resolve(eglGetDisplay);
+    resolve(eglInitialize);
+    resolve(eglTerminate);
+    resolve(eglBindAPI);
+    resolve(eglChooseConfig);
+    resolve(eglCreateContext);
+    resolve(eglDestroyContext);
+    resolve(eglCreatePbufferSurface);
+    resolve(eglDestroySurface);
+    resolve(eglMakeCurrent);
+
+    #undef resolve
+
+    /* Prefer Mesa's surfaceless platform, which needs neither a windowing system nor a GPU
+       (llvmpipe). Otherwise fall back to the default display and use a pbuffer. */
+    const char* client_ext = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    eglGetPlatformDisplayEXTProc eglGetPlatformDisplayEXT = (eglGetPlatformDisplayEXTProc)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    display = EGL_NO_DISPLAY;
+    if (client_ext && strstr(client_ext, "EGL_MESA_platform_surfaceless") && eglGetPlatformDisplayEXT)
+        display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        fprintf(stderr, "eglInitialize(): failed (0x%04X)\n", (unsigned int) eglGetError());
+        glava_abort();
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "eglBindAPI(EGL_OPENGL_API): failed (0x%04X)\n", (unsigned int) eglGetError());
+        glava_abort();
+    }
+
+    const char* ext = eglQueryString(display, EGL_EXTENSIONS);
+    surfaceless = ext && strstr(ext, "EGL_KHR_surfaceless_context");
+}
+
+static void* create_and_bind(const char* name, const char* class,
+                             const char* type, const char** states,
+                             size_t states_sz,
+                             int d, int h,
+                             int x, int y,
+                             int version_major, int version_minor,
+                             bool clickthrough, bool off) {
+
+    struct eglwin* w = malloc(sizeof(struct eglwin));
+    *w = (struct eglwin) {
+        .context = EGL_NO_CONTEXT,
+        .surface = EGL_NO_SURFACE,
+        .w       = d,
+        .h       = h,
+        .time    = 0.0
+    };
+
+    const EGLint config_attrs[] = {
+        EGL_SURFACE_TYPE,    surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint    num_config;
+    if (!eglChooseConfig(display, config_attrs, &config, 1, &num_config) || num_config < 1) {
+        fprintf(stderr, "eglChooseConfig(): failed to find a suitable config\n");
+        abort();
+    }
+
+    const EGLint context_attrs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       version_major,
+        EGL_CONTEXT_MINOR_VERSION,       version_minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    if (!(w->context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attrs))) {
+        fprintf(stderr, "eglCreateContext(): failed (0x%04X)\n", (unsigned int) eglGetError());
+        abort();
+    }
+
+    if (!surfaceless) {
+        static const EGLint pbuffer_attrs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        if (!(w->surface = eglCreatePbufferSurface(display, config, pbuffer_attrs))) {
+            fprintf(stderr, "eglCreatePbufferSurface(): failed (0x%04X)\n",
+                    (unsigned int) eglGetError());
+            abort();
+        }
+    }
+
+    if (!eglMakeCurrent(display, w->surface, w->surface, w->context)) {
+        fprintf(stderr, "eglMakeCurrent(): failed (0x%04X)\n", (unsigned int) eglGetError());
+        abort();
+    }
+
+    if (!glad_instantiated) {
+        gladLoadGLLoader((GLADloadproc) eglGetProcAddress);
+        glad_instantiated = true;
+    }
+
+    return w;
+}
+
+static double get_timert(void) {
+    struct timespec tv;
+    if (clock_gettime(CLOCK_MONOTONIC, &tv)) {
+        fprintf(stderr, "clock_gettime(CLOCK_MONOTONIC, ...): %s\n", strerror(errno));
+    }
+    return (double) tv.tv_sec + ((double) tv.tv_nsec / 1000000000.0);
+}
+
+static void set_geometry(struct eglwin* w, int x, int y, int d, int h) {
+    w->w = d;
+    w->h = h;
+}
+
+static void get_fbsize(struct eglwin* w, int* d, int* h) {
+    *d = w->w;
+    *h = w->h;
+}
+
+static void destroy(struct eglwin* w) {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); /* release context */
+    if (w->surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, w->surface);
+    eglDestroyContext(display, w->context);
+    free(w);
+}
+
+static void terminate(void) {
+    eglTerminate(display);
+    dlclose(hegl);
+    hegl = NULL;
+}
+
+static bool   should_close   (struct eglwin* w)               { return false; }
+static bool   should_render  (struct eglwin* w)               { return true;  }
+static bool   bg_changed     (struct eglwin* w)               { return false; }
+static void   swap_buffers   (struct eglwin* w)               {}
+static bool   poll_events    (struct eglwin* w)               { return false; }
+static void   raise          (struct eglwin* w)               {}
+static void   get_pos        (struct eglwin* w, int* x, int* y) { *x = 0; *y = 0; }
+static void   set_visible    (struct eglwin* w, bool visible) {}
+static double get_time       (struct eglwin* w)               { return get_timert() - w->time; }
+static void   set_time       (struct eglwin* w, double time)  { w->time = get_timert() - time; }
+
+static void set_swap       (int  _swap)        {}
+static void set_floating   (bool _floating)    {}
+static void set_decorated  (bool _decorated)   {}
+static void set_focused    (bool _focused)     {}
+static void set_maximized  (bool _maximized)   {}
+static void set_transparent(bool _transparent) {}
+
+/* No window manager, use the default presets */
+static const char* get_environment(void) { return NULL; }
+
+static unsigned int bind_pixmap(struct eglwin* w, unsigned long pixmap, int* d, int* h, bool* inverted) {
+    return 0;
+}
+
+WCB_ATTACH("egl", wcb_egl);
+
+#endif /* GLAVA_EGL */
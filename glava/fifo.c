@@ -36,7 +36,7 @@ static void* entry(void* data) {
     
     int fd;
     int16_t buf[ssz / 2];
-    size_t q;
+    size_t q, filled = 0; /* bytes of a partial chunk read while rendering offline */
     int timeout = 50;
     
     struct timespec tv_last = {}, tv;
@@ -56,6 +56,17 @@ static void* entry(void* data) {
     
     while (true) {
 
+        /* When rendering offline, only read ahead as far as the renderer has asked for */
+        pthread_mutex_lock(&audio->mutex);
+        while (audio->limit && audio->written >= audio->limit && audio->terminate != 1)
+            pthread_cond_wait(&audio->cond, &audio->mutex);
+        pthread_mutex_unlock(&audio->mutex);
+        
+        if (audio->terminate == 1) {
+            close(fd);
+            break;
+        }
+
         /* The poll timeout is set to accommodate an approximate UPS, but has little purpose except
            for effectively setting the rate of empty samples in the event of the FIFO descriptor
            blocking for long periods of time. */
@@ -65,6 +76,9 @@ static void* entry(void* data) {
                 fprintf(stderr, "FIFO backend: poll() failed (%s)\n", strerror(errno));
                 exit(EXIT_FAILURE);
             case 0:
+                /* Silence is only inserted in real time, offline rendering waits for the source */
+                if (audio->limit)
+                    break;
                 pthread_mutex_lock(&audio->mutex);
                 
                 memmove(bl, &bl[ssz / 4], buffer_offset * sizeof(float));
@@ -73,12 +87,40 @@ static void* entry(void* data) {
                 for (q = 0; q < (ssz / 4); ++q) bl[buffer_offset + q] = 0;
                 for (q = 0; q < (ssz / 4); ++q) br[buffer_offset + q] = 0;
             
+                audio->written += ssz / 4;
                 audio->modified = true;
+                pthread_cond_broadcast(&audio->cond);
                 
                 pthread_mutex_unlock(&audio->mutex);
                 break;
             default: {
-                read(fd, buf, sizeof(buf));
+                ssize_t rd = read(fd, (char*) buf + filled, sizeof(buf) - filled);
+                if (rd < 0) {
+                    if (errno == EINTR || errno == EAGAIN)
+                        break;
+                    fprintf(stderr, "FIFO backend: read() failed (%s)\n", strerror(errno));
+                    exit(EXIT_FAILURE);
+                }
+                if (audio->limit) {
+                    /* Offline rendering only writes whole chunks, so short reads from pipes do
+                       not insert silence; only the last chunk of the source is padded */
+                    filled += rd;
+                    if (rd > 0 && filled < sizeof(buf))
+                        break;
+                    if (filled == 0) {
+                        /* End of the source being rendered offline */
+                        pthread_mutex_lock(&audio->mutex);
+                        audio->eof = true;
+                        pthread_cond_broadcast(&audio->cond);
+                        pthread_mutex_unlock(&audio->mutex);
+                        close(fd);
+                        return 0;
+                    }
+                    rd = filled;
+                    filled = 0;
+                }
+                if ((size_t) rd < sizeof(buf))
+                    memset((char*) buf + rd, 0, sizeof(buf) - rd); /* pad short reads with silence */
                 clock_gettime(CLOCK_REALTIME, measured ? &tv : &tv_last);
                 if (measured) {
                     /* Set the timeout slightly higher than the delay between samples to prevent empty writes */
@@ -109,18 +151,14 @@ static void* entry(void* data) {
                     n++;
                 }
             
+                audio->written += ssz / 4;
                 audio->modified = true;
+                pthread_cond_broadcast(&audio->cond);
             
                 pthread_mutex_unlock(&audio->mutex);
                 break;
             }
         }
-        
-        if (audio->terminate == 1) {
-            close(fd);
-            break;
-        }
-        
     }
     
     return 0;
@@ -10,6 +10,10 @@ struct audio_data {
     volatile float* audio_out_r;
     volatile float* audio_out_l;
     bool modified;
+    size_t written; /* total samples written to each channel, wrapping */
+    size_t limit;   /* if nonzero, sources that can be read faster than real time wait while
+                       `written` has reached this (offline rendering) */
+    bool eof;       /* the source has ended, only reported while `limit` is used */
     size_t audio_buf_sz, sample_sz;
     int format;
     unsigned int rate;
@@ -17,6 +21,7 @@ struct audio_data {
     int channels;
 	int terminate; // shared variable used to terminate audio thread
     pthread_mutex_t mutex;
+    pthread_cond_t  cond; /* signaled when samples are written, or `limit` or `terminate` change */
 };
 
 struct audio_impl {
@@ -17,6 +17,7 @@
 #include "pulse_input.h"
 #include "render.h"
 #include "xwin.h"
+#include "output.h"
 
 #ifdef GLAD_DEBUG
 #define GLAVA_RELEASE_TYPE_PREFIX "debug, "
@@ -188,13 +189,21 @@ static const char* help_str =
     "                           of the installed shader directory, and linking any modules.\n"
     "-b, --backend            specifies a window creation backend to use. By default, the most\n"
     "                           appropriate backend will be used for the underlying windowing\n"
-    "                           system.\n"
+    "                           system. The \"egl\" backend renders headless without a display.\n"
     "-a, --audio=BACKEND      specifies an audio input backend to use.\n"
     "-p, --pipe[=BIND[:TYPE]] binds value(s) to be read from stdin. The input my be read using\n"
     "                           `@name` or `@name:default` syntax within shader sources.\n"
     "                           A stream of inputs (each overriding the previous) must be\n"
     "                           assigned with the `name = value` syntax and separated by\n"
     "                           newline (\'\\n\') characters.\n"
+    "-o, --output=FILE        renders offline at a fixed frame rate (see `setframerate`, 60 if\n"
+    "                           unlimited) and writes frames to FILE instead of displaying them,\n"
+    "                           or to stdout if FILE is \"-\". Each frame is rendered as soon as\n"
+    "                           the audio backend provides its samples, so file sources (ie.\n"
+    "                           `--audio=fifo` with a file as the source) render faster than\n"
+    "                           real time. Uses the \"egl\" backend unless `--backend` is given.\n"
+    "-O, --output-format=FMT  format for `--output`: \"y4m\" (default) for a YUV4MPEG2 stream,\n"
+    "                           or \"rgba\" for raw 8-bit RGBA frames.\n"
     "-V, --version            print application version and exit\n"
     "\n"
     "The REQUEST argument is evaluated identically to the \'#request\' preprocessor directive\n"
@@ -213,24 +222,26 @@ static const char* help_str =
     "\n"
     GLAVA_VERSION_STRING "\n";
 
-static const char* opt_str = "dhvVe:Cm:b:r:a:i::p::";
+static const char* opt_str = "dhvVe:Cm:b:r:a:o:O:i::p::";
 static struct option p_opts[] = {
-    {"help",        no_argument,       0, 'h'},
-    {"verbose",     no_argument,       0, 'v'},
-    {"desktop",     no_argument,       0, 'd'},
-    {"audio",       required_argument, 0, 'a'},
-    {"request",     required_argument, 0, 'r'},
-    {"entry",       required_argument, 0, 'e'},
-    {"force-mod",   required_argument, 0, 'm'},
-    {"copy-config", no_argument,       0, 'C'},
-    {"backend",     required_argument, 0, 'b'},
-    {"pipe",        optional_argument, 0, 'p'},
-    {"stdin",       optional_argument, 0, 'i'},
-    {"version",     no_argument,       0, 'V'},
+    {"help",          no_argument,       0, 'h'},
+    {"verbose",       no_argument,       0, 'v'},
+    {"desktop",       no_argument,       0, 'd'},
+    {"audio",         required_argument, 0, 'a'},
+    {"request",       required_argument, 0, 'r'},
+    {"entry",         required_argument, 0, 'e'},
+    {"force-mod",     required_argument, 0, 'm'},
+    {"copy-config",   no_argument,       0, 'C'},
+    {"backend",       required_argument, 0, 'b'},
+    {"pipe",          optional_argument, 0, 'p'},
+    {"stdin",         optional_argument, 0, 'i'},
+    {"output",        required_argument, 0, 'o'},
+    {"output-format", required_argument, 0, 'O'},
+    {"version",       no_argument,       0, 'V'},
     #ifdef GLAVA_DEBUG
-    {"run-tests",   no_argument,       0, 'T'},
+    {"run-tests",     no_argument,       0, 'T'},
     #endif
-    {0,             0,                 0,  0 }
+    {0,               0,                 0,  0 }
 };
 
 #define append_buf(buf, sz_store, ...)                      \
@@ -255,9 +266,53 @@ void glava_wait(glava_handle* ref) {
     pthread_mutex_unlock(&(*ref)->lock);
 }
 
+/* Texture of the latest complete frame. The renderer alternates between two textures, so this
+   is only valid until the next frame is drawn; use `glava_acquire` to sample it safely. */
 __attribute__((visibility("default")))
 unsigned int glava_tex(glava_handle r) {
-    return r->off_tex;
+    return __atomic_load_n(&r->off_tex, __ATOMIC_SEQ_CST);
+}
+
+/* Acquire the texture holding the latest complete frame, for sampling from a context sharing
+   objects with the renderer (see `glava_assign_external_ctx`). The renderer will not draw into
+   it until `glava_release` is called, which should follow as soon as the commands sampling it
+   have been issued. The frame's sequence number is stored in `seq`, if not NULL. */
+__attribute__((visibility("default")))
+unsigned int glava_acquire(glava_handle r, uint64_t* seq) {
+    return rd_acquire(r, seq);
+}
+
+__attribute__((visibility("default")))
+void glava_release(glava_handle r) {
+    rd_release(r);
+}
+
+/* Enable or disable asynchronous readback of presented frames. Frames are passed to `cb` on the
+   render thread as they complete, or retained for `glava_frame` if `cb` is NULL. */
+__attribute__((visibility("default")))
+void glava_readback(glava_handle r, bool enable, glava_frame_cb cb, void* user) {
+    pthread_mutex_lock(&r->readback.lock);
+    r->readback.cb   = cb;
+    r->readback.user = user;
+    pthread_mutex_unlock(&r->readback.lock);
+    __atomic_store_n(&r->readback.enabled, enable, __ATOMIC_SEQ_CST);
+}
+
+/* Copy the latest frame read back into `dst` if it is newer than the sequence number `last`,
+   returning its sequence number or 0 otherwise. The dimensions of the latest frame are always
+   stored in `w` and `h`, so `dst` can be resized if it was too small. */
+__attribute__((visibility("default")))
+uint64_t glava_frame(glava_handle r, uint64_t last, void* dst, size_t dst_sz, int* w, int* h) {
+    uint64_t seq = 0;
+    pthread_mutex_lock(&r->readback.lock);
+    *w = r->readback.w;
+    *h = r->readback.h;
+    if (r->readback.data && r->readback.seq > last && dst_sz >= r->readback.sz) {
+        memcpy(dst, r->readback.data, r->readback.sz);
+        seq = r->readback.seq;
+    }
+    pthread_mutex_unlock(&r->readback.lock);
+    return seq;
 }
 
 /* Atomic size request */
@@ -286,9 +341,19 @@ void glava_reload(glava_handle* ref) {
 }
 
 
-/* Main entry */
-__attribute__((visibility("default")))
-void glava_entry(int argc, char** argv, glava_handle* ret) {
+/* Options shared by `glava_entry` and `glava_create` */
+struct options {
+    const char* install_path, * user_path, * entry, * backend, * audio_impl_name,
+        * output_path, * output_format;
+    const char* shader_paths[3];
+    int stdin_type;
+    char** requests;       /* NULL terminated */
+    struct rd_bind* binds; /* terminated by a NULL name */
+    char* force_request;
+    bool verbose, desktop, test;
+};
+
+static void parse_options(struct options* o, int argc, char** argv) {
 
     /* Evaluate these macros only once, since they allocate */
     const char
@@ -297,8 +362,10 @@ void glava_entry(int argc, char** argv, glava_handle* ret) {
         * entry           = "rc.glsl",
         * force           = NULL,
         * backend         = NULL,
-        * audio_impl_name = "pulseaudio";
-    const char* system_shader_paths[] = { user_path, install_path, NULL };
+        * audio_impl_name = "pulseaudio",
+        * output_path     = NULL,
+        * output_format   = NULL;
+    char* force_req_buf = NULL;
     int stdin_type = STDIN_TYPE_NONE;
     
     char**          requests    = malloc(1);
@@ -309,6 +376,7 @@ void glava_entry(int argc, char** argv, glava_handle* ret) {
     bool verbose = false, copy_mode = false, desktop = false, test = false;
     
     int c, idx;
+    optind = 0; /* options may be parsed more than once per process */
     while ((c = getopt_long(argc, argv, opt_str, p_opts, &idx)) != -1) {
         switch (c) {
             case 'v': verbose   = true;   break;
@@ -319,6 +387,8 @@ void glava_entry(int argc, char** argv, glava_handle* ret) {
             case 'm': force           = optarg; break;
             case 'b': backend         = optarg; break;
             case 'a': audio_impl_name = optarg; break;
+            case 'o': output_path     = optarg; break;
+            case 'O': output_format   = optarg; break;
             case '?': glava_abort(); break;
             case 'V':
                 puts(GLAVA_VERSION_STRING);
@@ -450,7 +520,7 @@ void glava_entry(int argc, char** argv, glava_handle* ret) {
     /* Handle `--force` argument as a request override */
     if (force) {
         const size_t bsz = 5 + strlen(force);
-        char* force_req_buf = malloc(bsz);
+        force_req_buf = malloc(bsz);
         snprintf(force_req_buf, bsz, "mod %s", force);
         append_buf(requests, &requests_sz, force_req_buf);
     }
@@ -458,31 +528,109 @@ void glava_entry(int argc, char** argv, glava_handle* ret) {
     /* Null terminate array arguments */
     append_buf(requests, &requests_sz, NULL);
     append_buf(binds,    &binds_sz,    (struct rd_bind) { .name = NULL });
+
+    *o = (struct options) {
+        .install_path    = install_path,
+        .user_path       = user_path,
+        .entry           = entry,
+        .backend         = backend,
+        .audio_impl_name = audio_impl_name,
+        .output_path     = output_path,
+        .output_format   = output_format,
+        .shader_paths    = { user_path, install_path, NULL },
+        .stdin_type      = stdin_type,
+        .requests        = requests,
+        .binds           = binds,
+        .force_request   = force_req_buf,
+        .verbose         = verbose,
+        .desktop         = desktop,
+        .test            = test
+    };
+}
+
+static void free_options(struct options* o) {
+    free(o->requests);
+    free(o->binds);
+    free(o->force_request);
+}
+
+/* Render a frame with the audio written since the last one, `read` is the value of
+   `audio->written` at the last read */
+static bool render_frame(glava_renderer* rd, struct audio_data* audio,
+                         float* lb, float* rb, size_t* read) {
+    rd_time(rd); /* update timer for this frame */
+    
+    bool modified; /* if the audio buffer has been updated by the streaming thread */
+    size_t fresh = 0; /* samples written since the last read */
+
+    /* lock the audio mutex and read our data */
+    pthread_mutex_lock(&audio->mutex);
+    modified = audio->modified;
+    if (modified) {
+        /* create our own copies of the audio buffers, so the streaming
+           thread can continue to append to it */
+        memcpy(lb, (void*) audio->audio_out_l, rd->bufsize_request * sizeof(float));
+        memcpy(rb, (void*) audio->audio_out_r, rd->bufsize_request * sizeof(float));
+        audio->modified = false; /* set this flag to false until the next time we read */
+        fresh = audio->written - *read;
+        *read = audio->written;
+    }
+    pthread_mutex_unlock(&audio->mutex);
+
+    return rd_update(rd, lb, rb, rd->bufsize_request, modified, fresh);
+}
+
+/* Main entry */
+__attribute__((visibility("default")))
+void glava_entry(int argc, char** argv, glava_handle* ret) {
+
+    struct options o;
+    parse_options(&o, argc, argv);
     
     float* b0, * b1, * lb, * rb;
     size_t t;
     struct audio_data audio;
     struct audio_impl* impl = NULL;
+    struct output output = { .f = NULL };
     pthread_t thread;
-    int return_status;
+    int return_status, fps = 0;
     
     for (t = 0; t < audio_impls_idx; ++t) {
-        if (!strcmp(audio_impls[t]->name, audio_impl_name)) {
+        if (!strcmp(audio_impls[t]->name, o.audio_impl_name)) {
             impl = audio_impls[t];
             break;
         }
     }
 
     if (!impl) {
-        fprintf(stderr, "The specified audio backend (\"%s\") is not available.\n", audio_impl_name);
+        fprintf(stderr, "The specified audio backend (\"%s\") is not available.\n", o.audio_impl_name);
         glava_abort();
     }
 
+    if (o.output_path) {
+        if (!output_open(&output, o.output_path, o.output_format))
+            glava_abort();
+        #ifdef GLAVA_EGL
+        /* Offline rendering does not need a window */
+        if (!o.backend)
+            o.backend = "egl";
+        #endif
+    }
+
 instantiate: {}
-    glava_renderer* rd = rd_new(system_shader_paths, entry, (const char**) requests,
-                    backend, binds, stdin_type, desktop, verbose, test);
+    glava_renderer* rd = rd_new(o.shader_paths, o.entry, (const char**) o.requests,
+                    o.backend, o.binds, o.stdin_type, o.desktop, o.verbose, o.test);
     if (ret)
         __atomic_store_n(ret, rd, __ATOMIC_SEQ_CST);
+
+    if (o.output_path) {
+        fps = rd_get_offline_rate(rd);
+        if (!output.rate)
+            output.rate = fps;
+        rd->offline           = true;
+        rd->readback.lossless = true;
+        glava_readback(rd, true, output_frame, &output);
+    }
     
     b0 = malloc(rd->bufsize_request * sizeof(float));
     b1 = malloc(rd->bufsize_request * sizeof(float));
@@ -510,35 +658,51 @@ instantiate: {}
         .mutex        = PTHREAD_MUTEX_INITIALIZER,
         .audio_buf_sz = rd->bufsize_request,
         .sample_sz    = rd->samplesize_request,
-        .modified     = false
+        .modified     = false,
+        .written      = 0,
+        .limit        = o.output_path ? rd->rate_request / fps : 0,
+        .eof          = false,
+        .cond         = PTHREAD_COND_INITIALIZER
     };
     
     impl->init(&audio);
     
-    if (verbose) printf("Using audio source: %s\n", audio.source);
+    if (o.verbose) printf("Using audio source: %s\n", audio.source);
     
     pthread_create(&thread, NULL, impl->entry, (void*) &audio);
+    size_t read = 0; /* value of `audio.written` at the last read */
+    uint64_t frames = 0; /* frames rendered offline */
     while (__atomic_load_n(&rd->alive, __ATOMIC_SEQ_CST)) {
 
-        rd_time(rd); /* update timer for this frame */
-        
-        bool modified; /* if the audio buffer has been updated by the streaming thread */
-
-        /* lock the audio mutex and read our data */
-        pthread_mutex_lock(&audio.mutex);
-        modified = audio.modified;
-        if (modified) {
-            /* create our own copies of the audio buffers, so the streaming
-               thread can continue to append to it */
-            memcpy(lb, (void*) audio.audio_out_l, rd->bufsize_request * sizeof(float));
-            memcpy(rb, (void*) audio.audio_out_r, rd->bufsize_request * sizeof(float));
-            audio.modified = false; /* set this flag to false until the next time we read */
+        if (o.output_path) {
+            /* Offline frames are paced by the audio source rather than the clock: request the
+               samples up to the end of this frame, and wait until they have been written (or
+               the source ended, rendering any remaining samples as a last frame) */
+            size_t target = (size_t) ((frames + 1) * audio.rate / fps);
+            bool available;
+            pthread_mutex_lock(&audio.mutex);
+            audio.limit = target;
+            pthread_cond_broadcast(&audio.cond);
+            while (!(available = audio.written >= target || (audio.eof && audio.written != read))
+                   && !audio.eof && __atomic_load_n(&rd->alive, __ATOMIC_SEQ_CST)) {
+                struct timespec tv;
+                clock_gettime(CLOCK_REALTIME, &tv);
+                tv.tv_nsec += 50 * 1000000;
+                if (tv.tv_nsec >= 1000000000) {
+                    tv.tv_nsec -= 1000000000;
+                    ++tv.tv_sec;
+                }
+                pthread_cond_timedwait(&audio.cond, &audio.mutex, &tv);
+            }
+            pthread_mutex_unlock(&audio.mutex);
+            if (!available)
+                break; /* end of the audio source, or terminated */
+            ++frames;
         }
-        pthread_mutex_unlock(&audio.mutex);
 
-        bool ret = rd_update(rd, lb, rb, rd->bufsize_request, modified);
+        bool ret = render_frame(rd, &audio, lb, rb, &read);
         
-        if (!ret) {
+        if (!ret && !o.output_path) {
             /* Sleep for 50ms and then attempt to render again */
             struct timespec tv = {
                 .tv_sec = 0, .tv_nsec = 50 * 1000000
@@ -561,7 +725,10 @@ instantiate: {}
     }
     #endif
 
+    pthread_mutex_lock(&audio.mutex);
     audio.terminate = 1;
+    pthread_cond_broadcast(&audio.cond);
+    pthread_mutex_unlock(&audio.mutex);
     if ((return_status = pthread_join(thread, NULL))) {
         fprintf(stderr, "Failed to join with audio thread: %s\n", strerror(return_status));
     }
@@ -574,4 +741,134 @@ instantiate: {}
     rd_destroy(rd);
     if (__atomic_exchange_n(&reload, false, __ATOMIC_SEQ_CST))
         goto instantiate;
+    if (output.f)
+        output_close(&output);
+    free_options(&o);
+}
+
+/* Embedding API: renderers created with `glava_create` are stepped by the host on its own
+   schedule, with audio pushed by the host instead of read by an audio thread */
+
+struct glava_host {
+    struct options    opts;  /* referenced by the renderer (pipe bindings) */
+    struct audio_data audio; /* written by `glava_audio` */
+    float*            lb, * rb;
+    size_t            read;  /* value of `audio.written` at the last step */
+    struct timespec   last;  /* time of the last step */
+};
+
+/* Create a renderer from command line options (`argv[0]` is ignored). The renderer's context
+   is made current on the calling thread, which must be used for all further calls except
+   `glava_audio`. Audio backend and output options have no effect. */
+__attribute__((visibility("default")))
+struct glava_renderer* glava_create(int argc, char** argv) {
+    struct glava_host* h = malloc(sizeof(struct glava_host));
+    parse_options(&h->opts, argc, argv);
+    if (h->opts.output_path) {
+        fprintf(stderr, "`--output` cannot be used with an embedded renderer\n");
+        glava_abort();
+    }
+    
+    glava_renderer* rd = rd_new(h->opts.shader_paths, h->opts.entry,
+                                (const char**) h->opts.requests, h->opts.backend,
+                                h->opts.binds, h->opts.stdin_type, h->opts.desktop,
+                                h->opts.verbose, h->opts.test);
+    rd->host = h;
+    
+    h->lb   = calloc(rd->bufsize_request, sizeof(float));
+    h->rb   = calloc(rd->bufsize_request, sizeof(float));
+    h->read = 0;
+    h->last = (struct timespec) { .tv_sec = 0, .tv_nsec = 0 };
+    h->audio = (struct audio_data) {
+        .source       = NULL,
+        .rate         = (unsigned int) rd->rate_request,
+        .format       = -1,
+        .terminate    = 0,
+        .channels     = rd->mirror_input ? 1 : 2,
+        .audio_out_r  = calloc(rd->bufsize_request, sizeof(float)),
+        .audio_out_l  = calloc(rd->bufsize_request, sizeof(float)),
+        .mutex        = PTHREAD_MUTEX_INITIALIZER,
+        .audio_buf_sz = rd->bufsize_request,
+        .sample_sz    = rd->samplesize_request,
+        .modified     = false,
+        .written      = 0,
+        .limit        = 0,
+        .eof          = false,
+        .cond         = PTHREAD_COND_INITIALIZER
+    };
+    return rd;
+}
+
+/* Sample rate expected by `glava_audio`, as requested by the configuration */
+__attribute__((visibility("default")))
+unsigned int glava_rate(glava_handle r) {
+    return (unsigned int) r->rate_request;
+}
+
+/* Push `frames` audio frames of `channels` interleaved samples in the range [-1, 1]. Only the
+   left and right channels are used. May be called from any thread. */
+__attribute__((visibility("default")))
+void glava_audio(glava_handle r, const float* samples, size_t frames, int channels) {
+    struct audio_data* audio = &r->host->audio;
+    float* bl = (float*) audio->audio_out_l;
+    float* br = (float*) audio->audio_out_r;
+    size_t fsz = audio->audio_buf_sz, n = frames;
+    
+    /* Only the most recent samples fit in the buffer */
+    if (n > fsz) {
+        samples += (n - fsz) * channels;
+        n = fsz;
+    }
+    
+    pthread_mutex_lock(&audio->mutex);
+    
+    memmove(bl, &bl[n], (fsz - n) * sizeof(float));
+    memmove(br, &br[n], (fsz - n) * sizeof(float));
+    
+    for (size_t t = 0; t < n; ++t) {
+        const float* s = samples + t * channels;
+        float left = s[0], right = channels > 1 ? s[1] : s[0];
+        size_t idx = (fsz - n) + t;
+        
+        if (audio->channels == 1) {
+            bl[idx] = (left + right) / 2;
+            br[idx] = (left + right) / 2;
+        } else {
+            bl[idx] = left;
+            br[idx] = right;
+        }
+    }
+    audio->written += frames;
+    audio->modified = true;
+    
+    pthread_mutex_unlock(&audio->mutex);
+}
+
+/* Render a frame with the audio pushed since the last step. Does not sleep or wait for the next
+   frame, aside from vsync if it is enabled. Returns false once the renderer should be destroyed
+   (the window was closed, or `glava_terminate` was called). */
+__attribute__((visibility("default")))
+bool glava_step(glava_handle r) {
+    struct glava_host* h = r->host;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    r->step = h->last.tv_sec || h->last.tv_nsec
+        ? (double) (now.tv_sec - h->last.tv_sec) + (double) (now.tv_nsec - h->last.tv_nsec) / 1000000000.0
+        : 0.0;
+    h->last = now;
+    
+    render_frame(r, &h->audio, h->lb, h->rb, &h->read);
+    return __atomic_load_n(&r->alive, __ATOMIC_SEQ_CST);
+}
+
+__attribute__((visibility("default")))
+void glava_destroy(glava_handle r) {
+    struct glava_host* h = r->host;
+    rd_destroy(r);
+    free((void*) h->audio.audio_out_l);
+    free((void*) h->audio.audio_out_r);
+    free(h->lb);
+    free(h->rb);
+    free_options(&h->opts);
+    free(h);
 }
@@ -2,6 +2,7 @@
 #define _GLAVA_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <pthread.h>
 
@@ -9,11 +10,16 @@
 #define GLAVA_REQ_RESIZE 1
 
 struct gl_data;
+struct glava_host;
 struct glava_renderer;
 
 /* External API */
 
 typedef struct glava_renderer* volatile glava_handle;
+/* Receives frames read back from the renderer; `pixels` is RGBA with rows ordered bottom to
+   top, and is only valid for the duration of the call. Called from the render thread, and must
+   not call back into the readback API (`glava_readback` or `glava_frame`). */
+typedef void (*glava_frame_cb)(const unsigned char* pixels, int w, int h, uint64_t seq, void* user);
 __attribute__((noreturn, visibility("default"))) void (*glava_abort)            (void);
 __attribute__((noreturn, visibility("default"))) void (*glava_return)           (void);
 __attribute__((visibility("default")))           void glava_assign_external_ctx (void* ctx);
@@ -23,5 +29,21 @@ __attribute__((visibility("default")))           void glava_reload
 __attribute__((visibility("default")))           void glava_sizereq             (glava_handle r, int x, int y, int w, int h);
 __attribute__((visibility("default")))           void glava_wait                (glava_handle* ref);
 __attribute__((visibility("default")))   unsigned int glava_tex                 (glava_handle r);
+__attribute__((visibility("default")))   unsigned int glava_acquire             (glava_handle r, uint64_t* seq);
+__attribute__((visibility("default")))           void glava_release             (glava_handle r);
+__attribute__((visibility("default")))           void glava_readback            (glava_handle r, bool enable,
+                                                                                 glava_frame_cb cb, void* user);
+__attribute__((visibility("default")))       uint64_t glava_frame               (glava_handle r, uint64_t last,
+                                                                                 void* dst, size_t dst_sz,
+                                                                                 int* w, int* h);
+
+/* Embedding API, see `glava_create` */
+
+__attribute__((visibility("default"))) struct glava_renderer* glava_create      (int argc, char** argv);
+__attribute__((visibility("default")))   unsigned int glava_rate                (glava_handle r);
+__attribute__((visibility("default")))           void glava_audio               (glava_handle r, const float* samples,
+                                                                                 size_t frames, int channels);
+__attribute__((visibility("default")))           bool glava_step                (glava_handle r);
+__attribute__((visibility("default")))           void glava_destroy             (glava_handle r);
 
 #endif /* _GLAVA_H */
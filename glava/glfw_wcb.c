@@ -65,6 +65,10 @@ DECL_WINDOW_HINT_STUB(set_maximized);
 
 extern struct gl_wcb wcb_glfw;
 
+static bool damaged = true;
+
+static void refresh(GLFWwindow* w) { damaged = true; }
+
 static bool offscreen(void) { return false; }
 
 static void* create_and_bind(const char* name, const char* class,
@@ -93,6 +97,7 @@ static void* create_and_bind(const char* name, const char* class,
         xwin_addstate(&wcb_glfw, w, states[t]);
     
     glfwSetWindowPos(w, x, y);
+    glfwSetWindowRefreshCallback(w, refresh);
     glfwMakeContextCurrent(w);
     
     if (!glad_instantiated) {
@@ -129,6 +134,13 @@ static void swap_buffers(GLFWwindow* w) {
     glfwSwapBuffers(w);
     glfwPollEvents();
 }
+
+static bool poll_events(GLFWwindow* w) {
+    glfwPollEvents();
+    bool ret = damaged;
+    damaged = false;
+    return ret;
+}
     
 static Display* get_x11_display(void)                          { return glfwGetX11Display();      }
 static Window   get_x11_window (GLFWwindow* w)                 { return glfwGetX11Window(w);      }
@@ -146,6 +158,10 @@ static void     terminate      (void)                          { glfwTerminate()
 
 static const char* get_environment(void) { return xwin_detect_wm(&wcb_glfw); }
 
+static unsigned int bind_pixmap(GLFWwindow* w, unsigned long pixmap, int* d, int* h, bool* inverted) {
+    return 0;
+}
+
 WCB_ATTACH("glfw", wcb_glfw);
 
 #endif /* GLAVA_GLFW */
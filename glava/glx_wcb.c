@@ -149,8 +149,22 @@ typedef XID GLXPbuffer;
 #define GLX_CONTEXT_MAJOR_VERSION_ARB       0x2091
 #define GLX_CONTEXT_MINOR_VERSION_ARB       0x2092
 
+/* GLX_EXT_texture_from_pixmap extension definitions */
+
+#define GLX_BIND_TO_TEXTURE_RGB_EXT         0x20D0
+#define GLX_BIND_TO_TEXTURE_TARGETS_EXT     0x20D3
+#define GLX_Y_INVERTED_EXT                  0x20D4
+#define GLX_TEXTURE_FORMAT_EXT              0x20D5
+#define GLX_TEXTURE_TARGET_EXT              0x20D6
+#define GLX_TEXTURE_FORMAT_RGB_EXT          0x20D9
+#define GLX_TEXTURE_2D_EXT                  0x20DC
+#define GLX_TEXTURE_2D_BIT_EXT              0x00000002
+#define GLX_FRONT_LEFT_EXT                  0x20DE
+
 typedef GLXContext (*glXCreateContextAttribsARBProc)(Display*, GLXFBConfig, GLXContext, Bool, const int*);
 typedef void       (*glXSwapIntervalEXTProc)        (Display*, GLXDrawable, int);
+typedef void       (*glXBindTexImageEXTProc)        (Display*, GLXDrawable, int, const int*);
+typedef void       (*glXReleaseTexImageEXTProc)     (Display*, GLXDrawable, int);
 
 GLXFBConfig*    (*glXChooseFBConfig)       (Display* dpy, int screen, const int* attribList, int* nitems);
 XVisualInfo*    (*glXGetVisualFromFBConfig)(Display* dpy, GLXFBConfig config);
@@ -162,6 +176,9 @@ void            (*glXSwapBuffers)          (Display* dpy, GLXDrawable drawable);
 void            (*glXDestroyContext)       (Display* dpy, GLXContext ctx);
 Bool            (*glXQueryVersion)         (Display* dpy, int* major, int* minor);
 GLXPixmap       (*glXCreateGLXPixmap)      (Display* dpy, XVisualInfo* vis, Pixmap pixmap);
+GLXPixmap       (*glXCreatePixmap)         (Display* dpy, GLXFBConfig config, Pixmap pixmap, const int* attribList);
+void            (*glXDestroyPixmap)        (Display* dpy, GLXPixmap pixmap);
+const char*     (*glXQueryExtensionsString)(Display* dpy, int screen);
 
 extern struct gl_wcb wcb_glx;
 
@@ -176,11 +193,31 @@ struct glxwin {
     GLXContext context;
     double time;
     bool should_close, should_render, bg_changed, clickthrough, offscreen;
+    bool damaged; /* window contents were lost and need to be redrawn */
+    /* Geometry and map state, tracked from StructureNotify events to avoid round trips */
+    int x, y, width, height;
+    bool pos_stale;             /* position must be queried, ie. after the frame moved */
+    bool mapped, parent_mapped; /* map state of the window and its parent (WM frame) */
+    Window parent;
     char override_state;
     Pixmap    off_pixmap;
     GLXPixmap off_glxpm;
+    struct {
+        int       state;    /* TFP_UNKNOWN, TFP_UNSUPPORTED or TFP_SUPPORTED */
+        Pixmap    pixmap;   /* pixmap currently bound to `tex` */
+        GLXPixmap glxpm;
+        GLuint    tex;
+        int       w, h;
+        bool      inverted;
+        glXBindTexImageEXTProc    bind;
+        glXReleaseTexImageEXTProc release;
+    } tfp; /* GLX_EXT_texture_from_pixmap state, see `bind_pixmap` */
 };
 
+#define TFP_UNKNOWN     0
+#define TFP_UNSUPPORTED 1
+#define TFP_SUPPORTED   2
+
 static Atom ATOM__MOTIF_WM_HINTS, ATOM_WM_DELETE_WINDOW, ATOM_WM_PROTOCOLS, ATOM__NET_ACTIVE_WINDOW, ATOM__XROOTPMAP_ID;
 
 static GLXContext sharelist_ctx;
@@ -254,6 +291,9 @@ static void init(void) {
     resolve(glXDestroyContext);
     resolve(glXQueryVersion);
     resolve(glXCreateGLXPixmap);
+    resolve(glXCreatePixmap);
+    resolve(glXDestroyPixmap);
+    resolve(glXQueryExtensionsString);
 
     intern(_MOTIF_WM_HINTS,    false);
     intern(WM_DELETE_WINDOW,   true);
@@ -316,11 +356,57 @@ static void apply_clickthrough(struct glxwin* w) {
     }
 }
 
+/* Track the map state and geometry of the window's parent, which is usually a frame created by
+   the window manager. Minimized windows are often hidden by unmapping this frame instead of
+   the window itself. */
+static void track_parent(struct glxwin* w, Window parent) {
+    w->parent        = parent;
+    w->parent_mapped = true;
+    w->pos_stale     = true;
+    if (parent != DefaultRootWindow(display)) {
+        XWindowAttributes attrs;
+        XSelectInput(display, parent, StructureNotifyMask);
+        if (XGetWindowAttributes(display, parent, &attrs))
+            w->parent_mapped = attrs.map_state == IsViewable;
+    }
+}
+
 static void process_events(struct glxwin* w) {
     while (XPending(display) > 0) {
         XEvent ev;
         XNextEvent(display, &ev);
+        if (ev.xany.window != w->w) {
+            /* Events selected on the parent window */
+            if (w->parent != None && ev.xany.window == w->parent) {
+                switch (ev.type) {
+                    case ConfigureNotify: w->pos_stale     = true;  break;
+                    case MapNotify:       w->parent_mapped = true;  break;
+                    case UnmapNotify:     w->parent_mapped = false; break;
+                    default: break;
+                }
+                continue;
+            }
+            if (ev.type != PropertyNotify)
+                continue;
+        }
         switch (ev.type) {
+            case ConfigureNotify:
+                w->width  = ev.xconfigure.width;
+                w->height = ev.xconfigure.height;
+                /* Synthetic events from the window manager are in root coordinates, otherwise
+                   they are relative to the parent */
+                if (ev.xconfigure.send_event || w->parent == DefaultRootWindow(display)) {
+                    w->x = ev.xconfigure.x;
+                    w->y = ev.xconfigure.y;
+                    w->pos_stale = false;
+                } else w->pos_stale = true;
+                break;
+            case ReparentNotify:
+                track_parent(w, ev.xreparent.parent);
+                break;
+            case UnmapNotify:
+                w->mapped = false;
+                break;
             case ClientMessage:
                 if (ev.xclient.message_type  == ATOM_WM_PROTOCOLS
                     && ev.xclient.data.l[0]  == ATOM_WM_DELETE_WINDOW) {
@@ -328,9 +414,13 @@ static void process_events(struct glxwin* w) {
                 }
                 break;
             case MapNotify:
+                w->mapped = true;
                 apply_clickthrough(w);
                 XFlush(display);
                 break;
+            case Expose:
+                w->damaged = true;
+                break;
             case VisibilityNotify:
                 switch (ev.xvisibility.state) {
                     case VisibilityFullyObscured:
@@ -338,6 +428,8 @@ static void process_events(struct glxwin* w) {
                         break;
                     case VisibilityUnobscured:
                     case VisibilityPartiallyObscured:
+                        if (!w->should_render)
+                            w->damaged = true;
                         w->should_render = true;
                         break;
                     default:
@@ -374,8 +466,17 @@ static void* create_and_bind(const char* name, const char* class,
         .should_close   = false,
         .should_render  = true,
         .bg_changed     = false,
+        .damaged        = true,
         .clickthrough   = false,
-        .offscreen      = off
+        .offscreen      = off,
+        .x              = x,
+        .y              = y,
+        .width          = d,
+        .height         = h,
+        .pos_stale      = false,
+        .mapped         = false,
+        .parent_mapped  = true,
+        .parent         = None
     };
 
     XVisualInfo* vi;
@@ -473,6 +574,7 @@ static void* create_and_bind(const char* name, const char* class,
         fprintf(stderr, "XCreateWindow(): failed\n");
         abort();
     }
+    w->parent = DefaultRootWindow(display);
 
     bool desktop = false;
     
@@ -578,6 +680,12 @@ static void set_transparent(bool _transparent) { transparent = _transparent; }
 
 static void set_geometry(struct glxwin* w, int x, int y, int d, int h) {
     XMoveResizeWindow(display, w->w, x, y, (unsigned int) d, (unsigned int) h);
+    /* Assume the request is honoured until a ConfigureNotify event says otherwise; offscreen
+       windows are never managed, so this is always the case for them */
+    w->x      = x;
+    w->y      = y;
+    w->width  = d;
+    w->height = h;
 }
 
 static void set_visible(struct glxwin* w, bool visible) {
@@ -601,12 +709,10 @@ static bool should_render(struct glxwin* w) {
     if (w->offscreen)
         return true;
     /* For nearly all window managers, windows are 'minimized' by unmapping parent windows.
-       VisibilityNotify events are not sent in these instances, so we have to read window
-       attributes to see if our window isn't viewable. */
-    XWindowAttributes attrs;
-    XGetWindowAttributes(display, w->w, &attrs);
+       VisibilityNotify events are not sent in these instances, so we also track the map
+       state of the parent (see `track_parent`). */
     process_events(w);
-    return w->should_render && attrs.map_state == IsViewable;
+    return w->should_render && w->mapped && w->parent_mapped;
 }
 
 static void swap_buffers(struct glxwin* w) {
@@ -617,16 +723,28 @@ static void swap_buffers(struct glxwin* w) {
     process_events(w);
 }
 
+static bool poll_events(struct glxwin* w) {
+    process_events(w);
+    bool ret = w->damaged;
+    w->damaged = false;
+    return ret;
+}
+
 static void get_fbsize(struct glxwin* w, int* d, int* h) {
-    XWindowAttributes a;
-    XGetWindowAttributes(display, w->w, &a);
-    *d = a.width;
-    *h = a.height;
+    *d = w->width;
+    *h = w->height;
 }
 
 static void get_pos(struct glxwin* w, int* x, int* y) {
-    Window _ignored;
-    XTranslateCoordinates(display, w->w, DefaultRootWindow(display), 0, 0, x, y, &_ignored);
+    /* Only query the server if our position is unknown since the last event */
+    if (w->pos_stale) {
+        Window _ignored;
+        XTranslateCoordinates(display, w->w, DefaultRootWindow(display), 0, 0,
+                              &w->x, &w->y, &_ignored);
+        w->pos_stale = false;
+    }
+    *x = w->x;
+    *y = w->y;
 }
 
 static double get_timert(void) {
@@ -637,7 +755,106 @@ static double get_timert(void) {
     return (double) tv.tv_sec + ((double) tv.tv_nsec / 1000000000.0);
 }
 
+/* Bind an X pixmap (ie. the root background) directly to a texture. The pixmap is re-bound
+   on every call, since its contents are undefined after being changed while bound. */
+static unsigned int bind_pixmap(struct glxwin* w, unsigned long pixmap, int* d, int* h, bool* inverted) {
+    if (w->tfp.state == TFP_UNKNOWN) {
+        const char* ext = glXQueryExtensionsString(display, DefaultScreen(display));
+        w->tfp.state   = TFP_UNSUPPORTED;
+        w->tfp.bind    = (glXBindTexImageEXTProc)
+            glXGetProcAddressARB((const GLubyte*) "glXBindTexImageEXT");
+        w->tfp.release = (glXReleaseTexImageEXTProc)
+            glXGetProcAddressARB((const GLubyte*) "glXReleaseTexImageEXT");
+        if (ext && strstr(ext, "GLX_EXT_texture_from_pixmap") && w->tfp.bind && w->tfp.release)
+            w->tfp.state = TFP_SUPPORTED;
+    }
+    if (w->tfp.state != TFP_SUPPORTED)
+        return 0;
+    
+    if (w->tfp.pixmap == pixmap) {
+        glBindTexture(GL_TEXTURE_2D, w->tfp.tex);
+        w->tfp.release(display, w->tfp.glxpm, GLX_FRONT_LEFT_EXT);
+        w->tfp.bind(display, w->tfp.glxpm, GLX_FRONT_LEFT_EXT, NULL);
+        goto done;
+    }
+    
+    if (w->tfp.glxpm) {
+        glBindTexture(GL_TEXTURE_2D, w->tfp.tex);
+        w->tfp.release(display, w->tfp.glxpm, GLX_FRONT_LEFT_EXT);
+        glXDestroyPixmap(display, w->tfp.glxpm);
+        w->tfp.glxpm  = 0;
+        w->tfp.pixmap = None;
+    }
+    
+    Window root;
+    int px, py;
+    unsigned int pw, ph, border, depth;
+    if (!XGetGeometry(display, pixmap, &root, &px, &py, &pw, &ph, &border, &depth))
+        return 0;
+    
+    /* Find a config that can be bound to a texture and matches the pixmap depth */
+    static const int attrs[] = {
+        GLX_DRAWABLE_TYPE,               GLX_PIXMAP_BIT,
+        GLX_BIND_TO_TEXTURE_RGB_EXT,     True,
+        GLX_BIND_TO_TEXTURE_TARGETS_EXT, GLX_TEXTURE_2D_BIT_EXT,
+        GLX_DOUBLEBUFFER,                False,
+        None
+    };
+    int fb_sz, inv = 0;
+    GLXFBConfig* fbc = glXChooseFBConfig(display, DefaultScreen(display), attrs, &fb_sz);
+    GLXFBConfig config = NULL;
+    for (int t = 0; fbc && t < fb_sz && !config; ++t) {
+        XVisualInfo* xvi = glXGetVisualFromFBConfig(display, fbc[t]);
+        if (xvi) {
+            if (xvi->depth == (int) depth) {
+                config = fbc[t];
+                glXGetFBConfigAttrib(display, config, GLX_Y_INVERTED_EXT, &inv);
+            }
+            XFree(xvi);
+        }
+    }
+    if (fbc)
+        XFree(fbc);
+    if (!config) {
+        fprintf(stderr, "No GLX config for binding %d-bit pixmaps, copying the background instead\n",
+                (int) depth);
+        w->tfp.state = TFP_UNSUPPORTED;
+        return 0;
+    }
+    
+    const int pm_attrs[] = {
+        GLX_TEXTURE_TARGET_EXT, GLX_TEXTURE_2D_EXT,
+        GLX_TEXTURE_FORMAT_EXT, GLX_TEXTURE_FORMAT_RGB_EXT,
+        None
+    };
+    if (!(w->tfp.glxpm = glXCreatePixmap(display, config, pixmap, pm_attrs)))
+        return 0;
+    
+    if (!w->tfp.tex)
+        glGenTextures(1, &w->tfp.tex);
+    glBindTexture(GL_TEXTURE_2D, w->tfp.tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    w->tfp.bind(display, w->tfp.glxpm, GLX_FRONT_LEFT_EXT, NULL);
+    w->tfp.pixmap   = pixmap;
+    w->tfp.w        = (int) pw;
+    w->tfp.h        = (int) ph;
+    w->tfp.inverted = inv;
+done:
+    *d        = w->tfp.w;
+    *h        = w->tfp.h;
+    *inverted = w->tfp.inverted;
+    return w->tfp.tex;
+}
+
 static void destroy(struct glxwin* w) {
+    if (w->tfp.glxpm) {
+        glBindTexture(GL_TEXTURE_2D, w->tfp.tex);
+        w->tfp.release(display, w->tfp.glxpm, GLX_FRONT_LEFT_EXT);
+        glXDestroyPixmap(display, w->tfp.glxpm);
+    }
+    if (w->tfp.tex)
+        glDeleteTextures(1, &w->tfp.tex);
     glXMakeCurrent(display, None, NULL); /* release context */
     glXDestroyContext(display, w->context);
     /* Some picking around indicates the GLX pixmap (for offscreen rendering) is 
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "glava.h"
+#include "output.h"
+
+/* Writes frames read back from the renderer as a YUV4MPEG2 stream (4:4:4, which ffmpeg and
+   most encoders accept directly), or as raw RGBA for `-f rawvideo -pix_fmt rgba`. */
+
+bool output_open(struct output* out, const char* path, const char* format) {
+    *out = (struct output) { .f = NULL, .rate = 0, .buf = NULL };
+    if (!format || !strcmp(format, "y4m"))
+        out->format = OUTPUT_Y4M;
+    else if (!strcmp(format, "rgba"))
+        out->format = OUTPUT_RGBA;
+    else {
+        fprintf(stderr, "Invalid output format: \"%s\" (expected \"y4m\" or \"rgba\")\n", format);
+        return false;
+    }
+    if (!strcmp(path, "-")) {
+        /* Keep stdout exclusively for frames, messages printed by GLava go to stderr instead */
+        int fd;
+        fflush(stdout);
+        if ((fd = dup(STDOUT_FILENO)) == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1
+            || !(out->f = fdopen(fd, "wb"))) {
+            fprintf(stderr, "Failed to redirect stdout for output: %s\n", strerror(errno));
+            return false;
+        }
+    } else if (!(out->f = fopen(path, "wb"))) {
+        fprintf(stderr, "Failed to open output '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/* BT.601 limited range conversion of a bottom-up RGBA frame into top-down Y, U and V planes */
+static void convert_y4m(const unsigned char* pixels, int w, int h, unsigned char* dst) {
+    size_t plane = (size_t) w * h;
+    for (int y = 0; y < h; ++y) {
+        const unsigned char* row = pixels + (size_t) (h - 1 - y) * w * 4;
+        size_t o = (size_t) y * w;
+        for (int x = 0; x < w; ++x, ++o) {
+            int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            dst[o]             = (unsigned char) ((( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16);
+            dst[plane + o]     = (unsigned char) (((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+            dst[plane * 2 + o] = (unsigned char) (((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static void convert_rgba(const unsigned char* pixels, int w, int h, unsigned char* dst) {
+    size_t stride = (size_t) w * 4;
+    for (int y = 0; y < h; ++y)
+        memcpy(dst + (size_t) y * stride, pixels + (size_t) (h - 1 - y) * stride, stride);
+}
+
+/* `glava_frame_cb` for the renderer, called from the render thread */
+void output_frame(const unsigned char* pixels, int w, int h, uint64_t seq, void* ptr) {
+    struct output* out = (struct output*) ptr;
+    size_t sz = (size_t) w * h * (out->format == OUTPUT_Y4M ? 3 : 4);
+    if (!out->buf) {
+        out->w   = w;
+        out->h   = h;
+        out->buf = malloc(sz);
+        if (out->format == OUTPUT_Y4M)
+            fprintf(out->f, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", w, h, out->rate);
+    } else if (w != out->w || h != out->h) {
+        fprintf(stderr, "Output frame size changed (%dx%d -> %dx%d), "
+                "the window must not be resized while writing output\n", out->w, out->h, w, h);
+        glava_abort();
+    }
+
+    if (out->format == OUTPUT_Y4M) {
+        convert_y4m(pixels, w, h, out->buf);
+        fputs("FRAME\n", out->f);
+    } else convert_rgba(pixels, w, h, out->buf);
+
+    if (fwrite(out->buf, 1, sz, out->f) != sz) {
+        fprintf(stderr, "Failed to write output: %s\n", strerror(errno));
+        glava_abort();
+    }
+}
+
+void output_close(struct output* out) {
+    if (out->f)
+        fclose(out->f);
+    free(out->buf);
+    *out = (struct output) { .f = NULL };
+}
@@ -0,0 +1,24 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OUTPUT_Y4M  0
+#define OUTPUT_RGBA 1
+
+/* Raw video output for offline rendering (`--output`) */
+struct output {
+    FILE* f;
+    int format;
+    int rate;           /* frame rate, must be assigned before the first frame */
+    int w, h;           /* frame dimensions, assigned by the first frame */
+    unsigned char* buf; /* converted frame */
+};
+
+bool output_open (struct output* out, const char* path, const char* format);
+void output_frame(const unsigned char* pixels, int w, int h, uint64_t seq, void* out);
+void output_close(struct output* out);
+
+#endif /* OUTPUT_H */
@@ -0,0 +1,75 @@
+/* System state detection for rendering policies */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "policy.h"
+
+static const char* policy_names[POLICY_MAX] = {
+    [POLICY_BATTERY] = "battery",
+    [POLICY_LOAD]    = "load"
+};
+
+int policy_lookup(const char* name) {
+    for (int t = 0; t < POLICY_MAX; ++t) {
+        if (!strcmp(policy_names[t], name))
+            return t;
+    }
+    return POLICY_NONE;
+}
+
+/* Read the first line of `<path>/<supply>/<attr>` into `buf`, returning false on failure */
+static bool read_attr(const char* path, const char* supply, const char* attr,
+                      char* buf, size_t sz) {
+    char fpath[strlen(path) + strlen(supply) + strlen(attr) + 3];
+    snprintf(fpath, sizeof(fpath), "%s/%s/%s", path, supply, attr);
+    int fd = open(fpath, O_RDONLY);
+    if (fd == -1)
+        return false;
+    ssize_t n = read(fd, buf, sz - 1);
+    close(fd);
+    if (n <= 0)
+        return false;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return true;
+}
+
+/* The system is running on battery power if a battery is discharging, and no mains supply
+   (ie. an AC adapter) is online. Systems without a power supply class are never on battery. */
+bool policy_on_battery(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir)
+        return false;
+    bool discharging = false, mains = false;
+    struct dirent* d;
+    char type[32], value[32];
+    while ((d = readdir(dir)) != NULL) {
+        if (d->d_name[0] == '.' || !read_attr(path, d->d_name, "type", type, sizeof(type)))
+            continue;
+        if (!strcmp(type, "Mains")) {
+            if (read_attr(path, d->d_name, "online", value, sizeof(value)) && !strcmp(value, "1"))
+                mains = true;
+        } else if (!strcmp(type, "Battery")) {
+            if (read_attr(path, d->d_name, "status", value, sizeof(value))
+                && !strcmp(value, "Discharging"))
+                discharging = true;
+        }
+    }
+    closedir(dir);
+    return discharging && !mains;
+}
+
+/* One minute load average per online CPU */
+float policy_load(void) {
+    double load;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (getloadavg(&load, 1) != 1)
+        return 0.0F;
+    return (float) (load / (double) (cpus > 0 ? cpus : 1));
+}
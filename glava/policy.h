@@ -0,0 +1,21 @@
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>
+
+/* System states that rendering settings can be overridden for, see `#request setpolicy`. If
+   several states apply, the one with the highest value is used. */
+#define POLICY_NONE    -1
+#define POLICY_BATTERY 0
+#define POLICY_LOAD    1
+#define POLICY_MAX     2
+
+#define POLICY_POWER_SUPPLY_PATH "/sys/class/power_supply"
+#define POLICY_INTERVAL          5.0 /* seconds between checking the system state */
+
+int   policy_lookup    (const char* name);
+bool  policy_on_battery(const char* path);
+float policy_load      (void);
+
+#endif /* POLICY_H */
@@ -176,7 +176,9 @@ static void* entry(void* data) {
             }
             ++n;
         }
+        audio->written += n;
         audio->modified = true;
+        pthread_cond_broadcast(&audio->cond);
         
         pthread_mutex_unlock(&audio->mutex);
         
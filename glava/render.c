@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <dirent.h>
 #include <math.h>
@@ -20,6 +21,7 @@
 #include "render.h"
 #include "xwin.h"
 #include "glsl_ext.h"
+#include "policy.h"
 
 typeof(bind_types) bind_types = {
     [STDIN_TYPE_NONE]  = { .n = "NONE",  .i = STDIN_TYPE_NONE  },
@@ -64,13 +66,6 @@ static void* block_storage;
 #define PI 3.14159265359
 #define swap(a, b) do { __auto_type tmp = a; a = b; b = tmp; } while (0)
 
-#define IB_START_LEFT 0
-#define IB_END_LEFT 1
-#define IB_START_RIGHT 2
-#define IB_END_RIGHT 3
-#define IB_WORK_LEFT 4
-#define IB_WORK_RIGHT 5
-
 /* Only a single vertex shader is needed, since all rendering
    is done in the fragment shader over a fullscreen quad */
 #define VERTEX_SHADER_SRC                                               \
@@ -82,7 +77,7 @@ static void* block_storage;
 #endif
 
 bool glad_instantiated = false;
-struct gl_wcb* wcbs[2] = {};
+struct gl_wcb* wcbs[3] = {};
 static size_t wcbs_idx = 0;
 
 static inline void register_wcb(struct gl_wcb* wcb) { wcbs[wcbs_idx++] = wcb; }
@@ -122,6 +117,7 @@ struct gl_sampler_data {
 
 struct sm_fb {
     GLuint fbo, tex;
+    size_t sz;
 };
 
 /* Per-bind data containing the framebuffer and textures gravity output.
@@ -142,40 +138,160 @@ struct gl_bind {
     void (**transformations)(struct gl_data*, void**, void* data);
     size_t t_sz;
     struct sm_fb sm, av, gr_store;
+    struct sm_fb ps[2]; /* prefix sum passes, used alternately */
+    struct sm_fb key[2], key_mix; /* interpolation keyframes and their blended result */
+    int key_idx;            /* index of the most recent keyframe in `key` */
+    bool keyed;             /* if `key` holds valid keyframes */
     struct gr_fb gr;
     bool optimize_fft;
+    bool cached;            /* if `cache` holds the last value passed to `uniform` */
+    GLint cache[2];
+};
+
+/* Polyphase lowpass decimator for `setbufscale`. Only samples that are new since the last
+   update are filtered, and only at the positions that produce output; results are kept in a
+   ring that is mirrored at `out_sz`, so the latest `out_sz` outputs are always contiguous. */
+
+#define DECIMATE_TAPS 8 /* filter taps per phase */
+
+struct decimator {
+    size_t factor, in_sz;    /* configuration the filter and ring were built for */
+    size_t taps;             /* filter length, a multiple of `factor` and of the vector width */
+    float* coeffs;
+    size_t phase;            /* input samples since the last output */
+    size_t out_sz, head;     /* decimated buffer size, next write position in `ring` */
+    float* ring[2];          /* decimated output for each channel, `out_sz * 2` in length */
+    float* work[2];          /* per-frame copies of the latest output, transformed in-place */
+};
+
+/* Asynchronous readback of presented frames (see `glava_readback`). Each frame is copied into
+   a pixel buffer object with a fence, and delivered once the fence has signaled on a later
+   frame. If every buffer is still in flight the frame is dropped instead of waiting. */
+
+#define READBACK_RING    3
+#define READBACK_TIMEOUT 10 /* seconds to wait for a readback before giving up on it */
+
+#define OFFLINE_RATE 60 /* default frame rate for offline rendering, see `rd_get_offline_rate` */
+
+struct readback {
+    struct readback_slot {
+        GLuint pbo;
+        GLsync fence;
+        size_t sz;           /* allocated size of `pbo` */
+        int w, h;
+        uint64_t seq;
+    } slots[READBACK_RING];
+    size_t tail, pending;    /* oldest slot in flight, number of slots in flight */
+    uint64_t frames;         /* presented frames while readback was enabled */
 };
 
+/* Texture formats for screen framebuffer objects, selected with `#request format` */
+
+static const struct sfbo_format {
+    const char* name;
+    GLint internal;
+    GLenum format, type;
+} sfbo_formats[] = {
+    { .name = "rgba8",   .internal = GL_RGBA8,   .format = GL_BGRA, .type = GL_UNSIGNED_BYTE },
+    { .name = "rgba16f", .internal = GL_RGBA16F, .format = GL_RGBA, .type = GL_FLOAT         },
+    { .name = "rgba32f", .internal = GL_RGBA32F, .format = GL_RGBA, .type = GL_FLOAT         },
+    { .name = "rg8",     .internal = GL_RG8,     .format = GL_RG,   .type = GL_UNSIGNED_BYTE },
+    { .name = "rg16f",   .internal = GL_RG16F,   .format = GL_RG,   .type = GL_FLOAT         },
+    { .name = "r8",      .internal = GL_R8,      .format = GL_RED,  .type = GL_UNSIGNED_BYTE },
+    { .name = "r16f",    .internal = GL_R16F,    .format = GL_RED,  .type = GL_FLOAT         },
+    { .name = "r32f",    .internal = GL_R32F,    .format = GL_RED,  .type = GL_FLOAT         },
+    { .name = NULL }
+};
+
+static const struct sfbo_format* lookup_sfbo_format(const char* str) {
+    for (const struct sfbo_format* f = sfbo_formats; f->name != NULL; ++f) {
+        if (!strcmp(f->name, str))
+            return f;
+    }
+    return NULL;
+}
+
 /* GL screen framebuffer object */
 
 struct gl_sfbo {
-    GLuint fbo, tex, shader, stdin_uniform;
+    GLuint fbo, tex, shader;
     bool indirect, nativeonly;
+    bool column;            /* 1D pass, rendered to a single row before its parent stage */
+    char* column_src;       /* `#request column` source, only used while loading */
+    char* vertex_src;       /* `#request instances` or `bounds` vertex shader, only used while loading */
+    char* fold_src;         /* `#request fold` statement, only used while loading */
+    char* epilogue;         /* statements folded into this stage from the stages after it */
+    bool instanced;         /* draw `instances` copies of the quad with the module's vertex shader */
+    int instances;
+    const struct sfbo_format* format; /* texture format, RGBA8 if NULL */
+    int scale;              /* render at 1/scale of the window size (indirect stages only) */
+    bool valid;             /* the stage's render target still holds its last output */
+    bool changed;           /* the stage's inputs changed this frame */
+    int interval;           /* only update every `interval` frames */
+    float rate;             /* only update `rate` times per second, if positive */
+    int frames;             /* frames since the last update */
+    double updated;         /* time of the last update */
     const char* name;
     struct gl_bind* binds;
-    GLuint* pipe_uniforms;
     size_t binds_sz;
 };
 
+/* Stages updated at a lower rate than the window keep their own render target */
+#define DECIMATED(s) ((s)->interval > 1 || (s)->rate > 0.0F)
+
+/* `#request uniform` for a per-frame global, recorded while building a stage's shaders */
+struct frame_bind {
+    const char* name, * member, * type; /* uniform name, frame block member and GLSL type */
+    bool sized;                         /* value depends on the stage's render size */
+    const struct gl_sfbo* stage;
+};
+
 /* data for screen-space overlay (quad) */
 
 struct overlay_data {
     GLuint vbuf, vao;
 };
 
+/* GL state tracked while rendering a frame, to skip redundant state changes */
+
+#define ST_TEXTURE_UNITS 32
+
+struct gl_state {
+    GLuint fbo, program, vao;
+    GLenum active, blend_eq;
+    GLuint tex_1d[ST_TEXTURE_UNITS], tex_2d[ST_TEXTURE_UNITS];
+    GLint vw, vh;
+    int blend;              /* -1 if unknown */
+    unsigned int calls;     /* GL calls made through the tracker */
+    unsigned int skipped;   /* redundant GL calls skipped by the tracker */
+};
+
 struct gl_data {
     struct gl_sfbo* stages;
+    struct gl_sfbo* targets; /* render targets shared between indirect stages */
+    size_t targets_sz;
     struct overlay_data overlay;
-    GLuint audio_tex_r, audio_tex_l, bg_tex, sm_prog, av_prog, gr_prog, p_prog;
+    struct gl_state st;
+    GLuint frame_ubo;       /* per-frame globals shared by all stages, see `setup_frame_block` */
+    char* frame_header;     /* GLSL declaration of the frame block */
+    unsigned char* frame_data, * frame_last; /* block contents, and the last uploaded contents */
+    size_t frame_sz, stdin_offset, * pipe_offsets;
+    struct frame_bind* frame_binds; /* uniform requests that may be mapped to the frame block */
+    size_t frame_binds_sz;
+    const char* epilogue;   /* appended to fragment shaders while folding a stage */
+    GLuint audio_tex_r, audio_tex_l, bg_tex, sm_prog, av_prog, gr_prog, p_prog, ps_prog, kf_prog;
     size_t stages_sz, bufscale, avg_frames;
+    struct decimator dec;
     void* w;
     struct gl_wcb* wcb;
     int lww, lwh, lwx, lwy; /* last window dimensions */
     int rate;               /* framerate */
     double tcounter;
+    double ptime;           /* duration of the last presented frame */
+    double clock;           /* running time, in seconds */
     float time, timecycle;
     int fcounter, ucounter, kcounter;
-    bool print_fps, avg_window, interpolate, interpolate_glsl, force_geometry,
+    bool print_fps, avg_window, interpolate, force_geometry,
         force_raised, copy_desktop, smooth_pass, premultiply_alpha, check_fullscreen,
         clickthrough, mirror_input, accel_fft;
     void** t_data;
@@ -185,18 +301,48 @@ struct gl_data {
     struct {
         float r, g, b, a;
     } clear_color;
-    float* interpolate_buf[6];
     int geometry[4];
     int stdin_type;
     struct rd_bind* binds;
-    GLuint bg_prog, bg_utex, bg_screen;
-    bool bg_setup;
+    GLuint bg_prog, bg_utex, bg_uoffset, bg_uflip;
+    GLuint bg_view;         /* background texture to sample, `bg_tex` or a bound root pixmap */
+    int bg_offset[2], bg_flip;
+    struct gl_sfbo bg_sfbo; /* composited background, blitted under the final stage */
+    int bg_blit;            /* if `bg_sfbo` can be blitted to the window, -1 if unknown */
+    bool bg_setup, bg_dirty;
     GLuint sm_utex, sm_usz, sm_uw,
         gr_utex, gr_udiff,
-        p_utex;
+        p_utex, ps_utex, ps_ustep,
+        kf_ut0, kf_ut1, kf_ufactor;
     GLuint* av_utex;
     bool test_mode;
-    struct gl_sfbo off_sfbo;
+    bool verbose;
+    struct gl_sfbo off_sfbo[2]; /* offscreen output, drawn to alternately (see `off_begin`) */
+    int off_cur;                /* output buffer being drawn to, or last drawn to */
+    struct readback rb;
+    struct {
+        float budget;       /* frame time budget in seconds, disabled if zero */
+        int level;          /* GOV_* quality steps currently applied */
+        double work;        /* time taken by presented frames this second, excluding sleep */
+        int frames;         /* frames presented this second */
+        int recover;        /* consecutive seconds with enough headroom to step back up */
+        size_t bufscale;    /* values to restore when stepping back up */
+        int rate;
+    } gov;
+    struct {
+        struct {
+            bool set;       /* `#request setpolicy` was used for this state */
+            int rate;
+            size_t bufscale;
+            bool interpolate;
+        } states[POLICY_MAX];
+        int state;          /* POLICY_* state currently applied */
+        char* path;         /* power supply directory, see `setpowersupplypath` */
+        float load_threshold; /* load average per CPU for the "load" state, disabled if zero */
+        double checked;     /* time the system state was last checked */
+        size_t bufscale;    /* configured values, restored when no state applies */
+        int rate;
+    } policy;
     #ifdef GLAVA_DEBUG
     struct {
         float r, g, b, a;
@@ -211,6 +357,103 @@ bool rd_get_test_mode(struct glava_renderer* r) {
     return gl->test_mode;
 }
 
+/* Per-frame globals (window size, time, audio buffer size and values from stdin or `--pipe`)
+   are stored in a std140 uniform block that is declared in every shader's header, updated once
+   per frame and shared by all stages. */
+
+#define FRAME_BLOCK_NAME    "_GLAVA_FRAME"
+#define FRAME_BLOCK_BINDING 0
+
+/* Append a member to the frame block declaration, returning its std140 offset */
+static size_t frame_member(struct gl_data* gl, size_t* sz, const char* stype, int type,
+                           const char* fmt, const char* name) {
+    size_t align = 4, msz = 4;
+    switch (type) {
+        case STDIN_TYPE_VEC2: align = 8;  msz = 8;  break;
+        case STDIN_TYPE_VEC3: align = 16; msz = 12; break;
+        case STDIN_TYPE_VEC4: align = 16; msz = 16; break;
+    }
+    size_t offset = (*sz + align - 1) & ~(align - 1);
+    *sz = offset + msz;
+    
+    size_t len = strlen(gl->frame_header);
+    size_t inc = snprintf(NULL, 0, fmt, stype, name);
+    gl->frame_header = realloc(gl->frame_header, len + inc + 1);
+    snprintf(gl->frame_header + len, inc + 1, fmt, stype, name);
+    return offset;
+}
+
+static void setup_frame_block(struct gl_data* gl) {
+    size_t sz = 0, u = 0;
+    gl->frame_header = strdup("layout(std140) uniform " FRAME_BLOCK_NAME " {\n");
+    frame_member(gl, &sz, "ivec2", STDIN_TYPE_VEC2,  "    %s %s;\n", "_FRAME_SCREEN");
+    frame_member(gl, &sz, "float", STDIN_TYPE_FLOAT, "    %s %s;\n", "_FRAME_TIME");
+    frame_member(gl, &sz, "int",   STDIN_TYPE_INT,   "    %s %s;\n", "_FRAME_AUDIO_SZ");
+    if (gl->stdin_type != STDIN_TYPE_NONE) {
+        gl->stdin_offset = frame_member(gl, &sz, bind_types[gl->stdin_type].n, gl->stdin_type,
+                                        "    %s %s;\n", "STDIN");
+    }
+    for (struct rd_bind* bd = gl->binds; bd->name != NULL; ++bd) ++u;
+    gl->pipe_offsets = malloc(sizeof(size_t) * (u + 1));
+    u = 0;
+    for (struct rd_bind* bd = gl->binds; bd->name != NULL; ++bd)
+        gl->pipe_offsets[u++] = frame_member(gl, &sz, bd->stype, bd->type, "    %s _IN_%s;\n", bd->name);
+    size_t len = strlen(gl->frame_header);
+    gl->frame_header = realloc(gl->frame_header, len + 4);
+    strcpy(gl->frame_header + len, "};\n");
+    
+    gl->frame_sz   = (sz + 15) & ~15;
+    gl->frame_data = calloc(gl->frame_sz, 1);
+    gl->frame_last = calloc(gl->frame_sz, 1);
+    glGenBuffers(1, &gl->frame_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, gl->frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, gl->frame_sz, gl->frame_data, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, gl->frame_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/* Replace declarations of uniforms bound to per-frame globals with definitions that read the
+   frame block, so binds for these sources do not need to be set for every stage. Declarations
+   that do not match the type of the source are left as-is, and set like any other uniform. */
+static char* map_frame_uniforms(struct gl_data* gl, char* src, size_t len) {
+    char* header = strdup("");
+    for (size_t f = 0; f < gl->frame_binds_sz; ++f) {
+        struct frame_bind* fb = &gl->frame_binds[f];
+        /* reduced size stages have their own dimensions */
+        if (fb->sized && fb->stage->scale > 1)
+            continue;
+        size_t n_len = strlen(fb->name), t_len = strlen(fb->type);
+        bool mapped = false;
+        for (size_t t = 0; t + 7 < len; ++t) {
+            if (strncmp(src + t, "uniform", 7) || (t > 0 && (isalnum((unsigned char) src[t - 1]) || src[t - 1] == '_')))
+                continue;
+            size_t e = t + 7;
+            if (!isspace((unsigned char) src[e])) continue;
+            while (e < len && isspace((unsigned char) src[e])) ++e;
+            if (e + t_len >= len || strncmp(src + e, fb->type, t_len) || !isspace((unsigned char) src[e + t_len]))
+                continue;
+            e += t_len;
+            while (e < len && isspace((unsigned char) src[e])) ++e;
+            if (e + n_len >= len || strncmp(src + e, fb->name, n_len))
+                continue;
+            e += n_len;
+            while (e < len && isspace((unsigned char) src[e])) ++e;
+            if (e >= len || src[e] != ';')
+                continue;
+            for (; t <= e; ++t)
+                if (src[t] != '\n') src[t] = ' ';
+            mapped = true;
+        }
+        if (mapped) {
+            size_t h_len = strlen(header);
+            size_t inc = snprintf(NULL, 0, "#define %s %s\n", fb->name, fb->member);
+            header = realloc(header, h_len + inc + 1);
+            snprintf(header + h_len, inc + 1, "#define %s %s\n", fb->name, fb->member);
+        }
+    }
+    return header;
+}
+
 /* load shader file */
 static GLuint shaderload(const char*             rpath,
                          GLenum                  type,
@@ -248,20 +491,6 @@ static GLuint shaderload(const char*             rpath,
     
     const GLchar* map = raw ? shader : mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
 
-    char* bind_header = malloc(1);
-    bind_header[0] = '\0';
-    size_t bh_idx = 0;
-
-    const char* fmt = "uniform %s _IN_%s;\n";
-
-    /* Construct pipe binding header (containing uniforms) */
-    for (struct rd_bind* bd = gl->binds; bd->name != NULL; ++bd) {
-        size_t inc = snprintf(NULL, 0, fmt, bd->stype, bd->name);
-        bind_header = realloc(bind_header, bh_idx + inc + 1);
-        snprintf(bind_header + bh_idx, inc + 1, fmt, bd->stype, bd->name);
-        bh_idx += inc;
-    }
-    
     /* Append to header entries with a #define for each `#expand` control */
     MUTABLE char* efmt_header = malloc(1);
     MUTABLE size_t efmt_idx = 0;
@@ -293,7 +522,7 @@ static GLuint shaderload(const char*             rpath,
     };
     #undef EBIND
 
-    size_t pad = bh_idx + efmt_idx;
+    size_t pad = strlen(gl->frame_header) + efmt_idx;
     
     struct glsl_ext ext = {
         .source     = raw ? NULL : map,
@@ -310,30 +539,40 @@ static GLuint shaderload(const char*             rpath,
 
     /* If this is raw input, skip processing */
     if (!raw) ext_process(&ext, rpath);
+    
+    char* frame_defs = raw ? strdup("") : map_frame_uniforms(gl, ext.processed, ext.p_len);
+    pad += strlen(frame_defs);
+    
+    /* Run folded statements after the stage's own `main`, see `fold_target` */
+    bool fold = !raw && type == GL_FRAGMENT_SHADER && gl->epilogue;
+    static const GLchar* fold_fmt = "\n#undef main\nvoid main() {\n    _stage_main();\n%s}\n";
+    size_t fold_len = fold ? snprintf(NULL, 0, fold_fmt, gl->epilogue) : 0;
 
-    /* Format GLSL header with defines, pipe bindings, and expand constants. */
+    /* Format GLSL header with defines, the frame block (containing stdin and pipe bindings),
+       and expand constants. */
     static const GLchar* header_fmt =
         "#version %d\n"
         "#define _SMOOTH_FACTOR %.6f\n"
         "#define USE_STDIN %d\n"
-        "#if USE_STDIN == 1\n"
-        "uniform %s STDIN;\n"
-        "#endif\n" "%s\n" "%s";
+        "%s" "%s\n" "%s" "%s";
     
-    size_t blen = strlen(header_fmt) + 32 + pad;
-    GLchar* buf = malloc((blen * sizeof(GLchar*)) + ext.p_len);
+    size_t blen = strlen(header_fmt) + 64 + pad;
+    GLchar* buf = malloc((blen * sizeof(GLchar*)) + ext.p_len + fold_len + 1);
     int written = snprintf(buf, blen, header_fmt, (int) shader_version,
                            (double) gl->smooth_factor, gl->stdin_type != STDIN_TYPE_NONE,
-                           bind_types[gl->stdin_type].n, bind_header, efmt_header);
+                           gl->frame_header, frame_defs, efmt_header,
+                           fold ? "#define main _stage_main\n" : "");
+    free(frame_defs);
     if (written < 0) {
         fprintf(stderr, "snprintf() encoding error while prepending header to shader '%s'\n", path);
         return 0;
     }
     memcpy(buf + written, ext.processed, ext.p_len);
+    if (fold) snprintf(buf + written + ext.p_len, fold_len + 1, fold_fmt, gl->epilogue);
     if (!raw) munmap((void*) map, st.st_size);
     
     GLuint s = glCreateShader(type);
-    GLint sl = (GLint) (ext.p_len + written);
+    GLint sl = (GLint) (ext.p_len + written + fold_len);
     glShaderSource(s, 1, (const GLchar* const*) &buf, &sl);
     switch (glGetError()) {
         case GL_INVALID_VALUE:
@@ -463,16 +702,18 @@ static GLuint shaderlink_f(GLuint* arr) {
 }
 
 /* load shaders */
-#define shaderbuild(gl, shader_path, c, d, r, v, s, ...)                \
-    shaderbuild_f(gl, shader_path, c, d, r, v, s, (const char*[]) {__VA_ARGS__, 0})
+#define shaderbuild(gl, shader_path, c, d, r, v, s, vs, ...)            \
+    shaderbuild_f(gl, shader_path, c, d, r, v, s, vs, (const char*[]) {__VA_ARGS__, 0})
 static GLuint shaderbuild_f(struct gl_data* gl,
                             const char* shader_path,
                             const char* config, const char* defaults,
                             struct request_handler* handlers,
                             int shader_version,
                             bool* skipped,
+                            char* const* vertex, /* vertex shader path, may be set by requests */
                             const char** arr) {
     if (skipped) *skipped = false;
+    gl->frame_binds_sz = 0;
     const char* str;
     int i = 0, sz = 0, t;
     while ((str = arr[i++]) != NULL) ++sz;
@@ -500,9 +741,17 @@ static GLuint shaderbuild_f(struct gl_data* gl,
             }
         }
     }
-    /* load builtin vertex shader */
-    shaders[sz] = shaderload(NULL, GL_VERTEX_SHADER, VERTEX_SHADER_SRC,
-                             NULL, NULL, handlers, shader_version, true, NULL, gl);
+    if (vertex && *vertex) {
+        /* load vertex shader requested by the fragment shader(s) */
+        if (!(shaders[sz] = shaderload(*vertex, GL_VERTEX_SHADER,
+                                       shader_path, config, defaults, handlers,
+                                       shader_version, false, NULL, gl)))
+            return 0;
+    } else {
+        /* load builtin vertex shader */
+        shaders[sz] = shaderload(NULL, GL_VERTEX_SHADER, VERTEX_SHADER_SRC,
+                                 NULL, NULL, handlers, shader_version, true, NULL, gl);
+    }
     fflush(stdout);
     return shaderlink_f(shaders);
 }
@@ -518,11 +767,6 @@ static GLuint create_1d_tex() {
     return tex;
 }
 
-static void update_1d_tex(GLuint tex, size_t w, float* data) {
-    glBindTexture(GL_TEXTURE_1D, tex);
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_R16, w, 0, GL_RED, GL_FLOAT, data);
-}
-
 #define BIND_VEC2 0
 #define BIND_VEC3 1
 #define BIND_VEC4 2
@@ -534,6 +778,127 @@ static void update_1d_tex(GLuint tex, size_t w, float* data) {
 #define BIND_SAMPLER1D 8
 #define BIND_SAMPLER2D 9
 
+/* GL state tracking. Functions here skip state changes that would have no effect, and use
+   direct state access when available so textures and uniforms can be updated without binding
+   them first. The tracked state is reset at the start of each frame, since the state may be
+   changed by other code between frames. */
+
+#define ST_CALL(gl, cond, ...)                  \
+    ({                                          \
+        if (cond) {                             \
+            __VA_ARGS__;                        \
+            ++(gl)->st.calls;                   \
+        } else ++(gl)->st.skipped;              \
+    })
+
+static void st_reset(struct gl_state* st) {
+    st->fbo      = (GLuint) -1;
+    st->program  = (GLuint) -1;
+    st->vao      = (GLuint) -1;
+    st->active   = (GLenum) -1;
+    st->blend_eq = (GLenum) -1;
+    st->vw       = -1;
+    st->vh       = -1;
+    st->blend    = -1;
+    for (size_t t = 0; t < ST_TEXTURE_UNITS; ++t) {
+        st->tex_1d[t] = (GLuint) -1;
+        st->tex_2d[t] = (GLuint) -1;
+    }
+}
+
+static void st_fbo(struct gl_data* gl, GLuint fbo) {
+    ST_CALL(gl, gl->st.fbo != fbo, glBindFramebuffer(GL_FRAMEBUFFER, gl->st.fbo = fbo));
+}
+
+static void st_program(struct gl_data* gl, GLuint program) {
+    ST_CALL(gl, gl->st.program != program, glUseProgram(gl->st.program = program));
+}
+
+static void st_active(struct gl_data* gl, GLuint unit) {
+    ST_CALL(gl, gl->st.active != unit, glActiveTexture(GL_TEXTURE0 + (gl->st.active = unit)));
+}
+
+static void st_texture(struct gl_data* gl, GLuint unit, GLenum target, GLuint tex) {
+    GLuint* cache = NULL;
+    if (unit < ST_TEXTURE_UNITS)
+        cache = target == GL_TEXTURE_1D ? &gl->st.tex_1d[unit] : &gl->st.tex_2d[unit];
+    ST_CALL(gl, !cache || *cache != tex, ({
+                if (cache) *cache = tex;
+                /* unbinding with `glBindTextureUnit` would clear every target on the unit */
+                if (GLAD_GL_VERSION_4_5 && tex != 0)
+                    glBindTextureUnit(unit, tex);
+                else {
+                    st_active(gl, unit);
+                    glBindTexture(target, tex);
+                }
+            }));
+}
+
+static void st_viewport(struct gl_data* gl, GLint w, GLint h) {
+    ST_CALL(gl, gl->st.vw != w || gl->st.vh != h,
+            glViewport(0, 0, gl->st.vw = w, gl->st.vh = h));
+}
+
+static void st_blend(struct gl_data* gl, bool blend) {
+    ST_CALL(gl, gl->st.blend != (int) blend, ({
+                gl->st.blend = (int) blend;
+                if (blend) glEnable(GL_BLEND);
+                else       glDisable(GL_BLEND);
+            }));
+}
+
+static void st_blend_eq(struct gl_data* gl, GLenum eq) {
+    ST_CALL(gl, gl->st.blend_eq != eq, glBlendEquation(gl->st.blend_eq = eq));
+}
+
+/* Uniforms are set on `program` directly if possible, otherwise it is made current */
+
+static void st_uniform1i(struct gl_data* gl, GLuint program, GLint loc, GLint v) {
+    if (GLAD_GL_VERSION_4_1) glProgramUniform1i(program, loc, v);
+    else { st_program(gl, program); glUniform1i(loc, v); }
+    ++gl->st.calls;
+}
+
+static void st_uniform1f(struct gl_data* gl, GLuint program, GLint loc, GLfloat v) {
+    if (GLAD_GL_VERSION_4_1) glProgramUniform1f(program, loc, v);
+    else { st_program(gl, program); glUniform1f(loc, v); }
+    ++gl->st.calls;
+}
+
+static void st_uniform2i(struct gl_data* gl, GLuint program, GLint loc, GLint x, GLint y) {
+    if (GLAD_GL_VERSION_4_1) glProgramUniform2i(program, loc, x, y);
+    else { st_program(gl, program); glUniform2i(loc, x, y); }
+    ++gl->st.calls;
+}
+
+/* Bound uniforms keep their values between frames, so they are only passed when changed */
+static void st_bind_uniform(struct gl_data* gl, GLuint program, struct gl_bind* bind,
+                            GLint x, GLint y) {
+    if (bind->cached && bind->cache[0] == x && bind->cache[1] == y) {
+        ++gl->st.skipped;
+        return;
+    }
+    bind->cached   = true;
+    bind->cache[0] = x;
+    bind->cache[1] = y;
+    if (bind->type == BIND_IVEC2) st_uniform2i(gl, program, bind->uniform, x, y);
+    else                          st_uniform1i(gl, program, bind->uniform, x);
+}
+
+static void update_1d_tex(struct gl_data* gl, GLuint unit, GLuint tex, size_t w, float* data) {
+    st_active(gl, unit);
+    st_texture(gl, unit, GL_TEXTURE_1D, tex);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R16, w, 0, GL_RED, GL_FLOAT, data);
+}
+
+/* Column stages are one texel high and span the longer window axis, so modules can lay out
+   columns along either direction. They default to floats since they usually contain
+   unnormalized values (ie. amplified audio) */
+#define COLUMN_LENGTH(w, h) ((w) > (h) ? (w) : (h))
+
+/* Dimensions of a stage's render target; reduced size stages are never smaller than a pixel */
+#define SCALED_SIZE(sz, scale) ((scale) > 1 ? ((sz) / (scale) > 0 ? (sz) / (scale) : 1) : (sz))
+
 /* setup screen framebuffer object and its texture */
 
 static void setup_sfbo(struct gl_sfbo* s, int w, int h) {
@@ -542,9 +907,18 @@ static void setup_sfbo(struct gl_sfbo* s, int w, int h) {
     s->indirect = true;
     /* bind texture and setup space */
     glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+    /* reduced size targets are filtered so the next stage can sample them at full size */
+    GLint filter = s->scale > 1 ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    const struct sfbo_format* f = s->format ? s->format : &sfbo_formats[0];
+    if (s->column)
+        glTexImage2D(GL_TEXTURE_2D, 0, f->internal, COLUMN_LENGTH(w, h), 1, 0, f->format, f->type, NULL);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, f->internal, SCALED_SIZE(w, s->scale), SCALED_SIZE(h, s->scale),
+                     0, f->format, f->type, NULL);
     
     /* setup and bind framebuffer to texture */
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
@@ -575,20 +949,25 @@ static void overlay(struct overlay_data* d) {
     glGenVertexArrays(1, &d->vao);
     glBindVertexArray(d->vao);
     
+    /* the enabled attribute is part of the vertex array state, so it can be left enabled */
     glEnableVertexAttribArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, d->vbuf);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*) 0);
-    glDisableVertexAttribArray(0);
 
     glBindVertexArray(0);
 }
 
-static void drawoverlay(const struct overlay_data* d) {
-    glBindVertexArray(d->vao);
-    glEnableVertexAttribArray(0);
+static void drawoverlay(struct gl_data* gl) {
+    ST_CALL(gl, gl->st.vao != gl->overlay.vao, glBindVertexArray(gl->st.vao = gl->overlay.vao));
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glDisableVertexAttribArray(0);
-    glBindVertexArray(0);
+    ++gl->st.calls;
+}
+
+/* draw `count` instances of the overlay quad, to be positioned by a module's vertex shader */
+static void drawinstanced(struct gl_data* gl, GLsizei count) {
+    ST_CALL(gl, gl->st.vao != gl->overlay.vao, glBindVertexArray(gl->st.vao = gl->overlay.vao));
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+    ++gl->st.calls;
 }
 
 #define TRANSFORM_NONE 0
@@ -654,9 +1033,22 @@ static struct gl_bind_src bind_sources[] = {
     #define SRC_SCREEN 4
     { .name = "screen", .type = BIND_IVEC2, .src_type = SRC_SCREEN },
     #define SRC_TIME 5
-    { .name = "time", .type = BIND_FLOAT, .src_type = SRC_SCREEN }
+    { .name = "time", .type = BIND_FLOAT, .src_type = SRC_TIME },
+    #define SRC_COLUMN 6
+    { .name = "column", .type = BIND_SAMPLER2D, .src_type = SRC_COLUMN },
+    #define SRC_AUDIO_L_PSUM 7
+    { .name = "audio_l_psum", .type = BIND_SAMPLER1D, .src_type = SRC_AUDIO_L_PSUM },
+    #define SRC_AUDIO_R_PSUM 8
+    { .name = "audio_r_psum", .type = BIND_SAMPLER1D, .src_type = SRC_AUDIO_R_PSUM }
 };
 
+/* Texture units used for `column` and prefix sum binds. These are bound after all other
+   uniforms are handled, since the audio passes use the units following their own as
+   scratch space. */
+#define COLUMN_TEXTURE_UNIT 3
+#define PSUM_TEXTURE_UNIT(offset) (COLUMN_TEXTURE_UNIT + (offset))
+#define KEYFRAME_TEXTURE_UNIT (PSUM_TEXTURE_UNIT(2) + 1)
+
 #define window(t, sz) (0.53836 - (0.46164 * cos(TWOPI * (double) t  / (double) sz)))
 #define window_frame(t, sz) (0.6 - (0.4 * cos(TWOPI * (double) t / (double) sz)))
 #define ALLOC_ONCE(u, udata, sz)                \
@@ -864,6 +1256,51 @@ static struct gl_bind_src* lookup_bind_src(const char* str) {
     return NULL;
 }
 
+/* Obtain uniform locations for the bindings of a freshly linked stage */
+static void setup_stage_uniforms(struct gl_data* gl, struct gl_sfbo* s) {
+    glUseProgram(s->shader);
+
+    /* Setup uniform bindings */
+    size_t b;
+    for (b = 0; b < s->binds_sz; ++b) {
+        s->binds[b].uniform = glGetUniformLocation(s->shader, s->binds[b].name);
+    }
+    /* The frame block is optimized out of stages that do not use it */
+    GLuint block = glGetUniformBlockIndex(s->shader, FRAME_BLOCK_NAME);
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(s->shader, block, FRAME_BLOCK_BINDING);
+    glBindFragDataLocation(s->shader, 1, "fragment");
+    glUseProgram(0);
+}
+
+/* Find the stage that the pointwise stage `stages[n]` can be folded into, or NULL if it must
+   be drawn as its own pass. Folding appends the `#request fold` statement to the previous
+   stage's `main`, instead of reading the previous stage's output in another full-screen pass.
+   Fragments that the previous stage does not write keep the clear color, so folding is only
+   done when clearing to transparent black (which the statement must leave unchanged). */
+static struct gl_sfbo* fold_target(struct gl_data* gl, struct gl_sfbo* stages, size_t n) {
+    struct gl_sfbo* s = &stages[n];
+    if (s->column_src || s->instanced || s->scale > 1 || DECIMATED(s))
+        return NULL;
+    if (gl->clear_color.r != 0.0F || gl->clear_color.g != 0.0F ||
+        gl->clear_color.b != 0.0F || gl->clear_color.a != 0.0F)
+        return NULL;
+    for (size_t b = 0; b < s->binds_sz; ++b) {
+        if (s->binds[b].src_type != SRC_PREV)
+            return NULL;
+    }
+    /* the previous stage is the last one that is drawn */
+    struct gl_sfbo* prev = NULL;
+    for (size_t t = 0; t < n; ++t) {
+        if (stages[t].shader && (gl->premultiply_alpha || !stages[t].nativeonly))
+            prev = &stages[t];
+    }
+    if (!prev || prev->scale > 1 || DECIMATED(prev)
+        || glGetFragDataLocation(prev->shader, "fragment") == -1)
+        return NULL;
+    return prev;
+}
+
 struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                               const char**    requests,     const char* force_backend,
                               struct rd_bind* bindings,     int         stdin_type,
@@ -876,7 +1313,10 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     *r = (struct glava_renderer) {
         .alive                = true,
         .mirror_input         = false,
+        .offline              = false,
+        .step                 = 0.0,
         .gl                   = malloc(sizeof(struct gl_data)),
+        .host                 = NULL,
         .bufsize_request      = 8192,
         .rate_request         = 22000,
         .samplesize_request   = 1024,
@@ -885,7 +1325,16 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         .lock                 = PTHREAD_MUTEX_INITIALIZER,
         .cond                 = PTHREAD_COND_INITIALIZER,
         .sizereq_flag         = 0,
-        .flag                 = false
+        .flag                 = false,
+        .out                  = { .front = 0, .held = -1, .seq = 0 },
+        .readback             = {
+            .enabled  = false,
+            .lossless = false,
+            .cb       = NULL,
+            .lock     = PTHREAD_MUTEX_INITIALIZER,
+            .data     = NULL,
+            .seq      = 0
+        }
     };
 
     pthread_mutex_lock(&r->lock);
@@ -897,6 +1346,8 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         .stages            = NULL,
         .rate              = 0,
         .tcounter          = 0.0,
+        .ptime             = 0.0,
+        .clock             = 0.0,
         .fcounter          = 0,
         .ucounter          = 0,
         .kcounter          = 0,
@@ -910,7 +1361,6 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         .avg_window        = true,
         .gravity_step      = 4.2,
         .interpolate       = true,
-        .interpolate_glsl  = false,
         .force_geometry    = false,
         .force_raised      = false,
         .smooth_factor     = 0.025,
@@ -921,6 +1371,8 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         .av_prog           = 0,
         .gr_prog           = 0,
         .p_prog            = 0,
+        .ps_prog           = 0,
+        .kf_prog           = 0,
         .copy_desktop      = true,
         .premultiply_alpha = true,
         .mirror_input      = false,
@@ -931,20 +1383,27 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         .fft_cutoff        = 0.3F,
         .geometry          = { 0, 0, 500, 400 },
         .clear_color       = { 0.0F, 0.0F, 0.0F, 0.0F },
-        .interpolate_buf   = { [0] = NULL },
         .clickthrough      = false,
         .stdin_type        = stdin_type,
         .binds             = bindings,
         .bg_setup          = false,
+        .bg_dirty          = true,
+        .bg_blit           = -1,
         .test_mode         = test_mode,
+        .verbose           = verbose,
+        .gov               = { .budget = 0.0F, .level = 0 },
+        .policy            = { .state = POLICY_NONE, .path = NULL, .load_threshold = 0.0F },
         .off_sfbo          = {
-            .name       = "test",
-            .shader     = 0,
-            .indirect   = false,
-            .nativeonly = false,
-            .binds      = NULL,
-            .binds_sz   = 0
+            [0 ... 1] = {
+                .name       = "test",
+                .shader     = 0,
+                .indirect   = false,
+                .nativeonly = false,
+                .binds      = NULL,
+                .binds_sz   = 0
+            }
         },
+        .off_cur           = 0,
         #ifdef GLAVA_DEBUG
         .test_eval_color   = { 0.0F, 0.0F, 0.0F, 0.0F },
         .debug_verbose     = verbose,
@@ -964,6 +1423,9 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         #ifdef GLAVA_GLX
         DECL_WCB(wcb_glx);
         #endif
+        #ifdef GLAVA_EGL
+        DECL_WCB(wcb_egl);
+        #endif
     }
     
     #ifdef GLAVA_GLFW
@@ -1120,6 +1582,106 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                   }
               })
         },
+        { .name = "column", .fmt = "s",
+          .handler = RHANDLER(name, args, {
+                  if (!current || current->column) {
+                      fprintf(stderr, "`column` request needs module context"
+                              " (and cannot be used in a column pass)\n");
+                      glava_abort();
+                  }
+                  if (current->column_src) free(current->column_src);
+                  current->column_src = strdup((char*) args[0]);
+              })
+        },
+        { .name = "format", .fmt = "s",
+          .handler = RHANDLER(name, args, {
+                  if (!current) {
+                      fprintf(stderr, "`format` request needs module context\n");
+                      glava_abort();
+                  }
+                  if (!(current->format = lookup_sfbo_format((const char*) args[0]))) {
+                      fprintf(stderr, "Invalid stage format: '%s', valid formats are:\n",
+                              (const char*) args[0]);
+                      for (const struct sfbo_format* f = sfbo_formats; f->name != NULL; ++f)
+                          fprintf(stderr, "\t\"%s\"\n", f->name);
+                      glava_abort();
+                  }
+              })
+        },
+        { .name = "scale", .fmt = "i",
+          .handler = RHANDLER(name, args, {
+                  if (!current || current->column) {
+                      fprintf(stderr, "`scale` request needs module context"
+                              " (and cannot be used in a column pass)\n");
+                      glava_abort();
+                  }
+                  if (*(int*) args[0] < 1) {
+                      fprintf(stderr, "Invalid stage scale: %d, must be at least 1\n", *(int*) args[0]);
+                      glava_abort();
+                  }
+                  current->scale = *(int*) args[0];
+              })
+        },
+        { .name = "interval", .fmt = "i",
+          .handler = RHANDLER(name, args, {
+                  if (!current) {
+                      fprintf(stderr, "`interval` request needs module context\n");
+                      glava_abort();
+                  }
+                  if (*(int*) args[0] < 1) {
+                      fprintf(stderr, "Invalid stage interval: %d, must be at least 1\n", *(int*) args[0]);
+                      glava_abort();
+                  }
+                  current->interval = *(int*) args[0];
+              })
+        },
+        { .name = "rate", .fmt = "f",
+          .handler = RHANDLER(name, args, {
+                  if (!current) {
+                      fprintf(stderr, "`rate` request needs module context\n");
+                      glava_abort();
+                  }
+                  current->rate = *(float*) args[0];
+              })
+        },
+        { .name = "fold", .fmt = "s",
+          .handler = RHANDLER(name, args, {
+                  if (!current || current->column) {
+                      fprintf(stderr, "`fold` request needs module context"
+                              " (and cannot be used in a column pass)\n");
+                      glava_abort();
+                  }
+                  if (current->fold_src) free(current->fold_src);
+                  current->fold_src = strdup((char*) args[0]);
+              })
+        },
+        { .name = "instances", .fmt = "si",
+          .handler = RHANDLER(name, args, {
+                  if (!current || current->column) {
+                      fprintf(stderr, "`instances` request needs module context"
+                              " (and cannot be used in a column pass)\n");
+                      glava_abort();
+                  }
+                  if (current->vertex_src) free(current->vertex_src);
+                  current->vertex_src = strdup((char*) args[0]);
+                  current->instanced  = true;
+                  current->instances  = *(int*) args[1];
+              })
+        },
+        { .name = "bounds", .fmt = "s",
+          .handler = RHANDLER(name, args, {
+                  if (!current || current->column) {
+                      fprintf(stderr, "`bounds` request needs module context"
+                              " (and cannot be used in a column pass)\n");
+                      glava_abort();
+                  }
+                  /* a single quad, positioned over the area the stage may draw to */
+                  if (current->vertex_src) free(current->vertex_src);
+                  current->vertex_src = strdup((char*) args[0]);
+                  current->instanced  = true;
+                  current->instances  = 1;
+              })
+        },
         WINDOW_HINT(floating),
         WINDOW_HINT(decorated),
         WINDOW_HINT(focused),
@@ -1167,6 +1729,35 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
           .handler = RHANDLER(name, args, { gl->wcb->set_swap(*(int*) args[0]); })         },
         { .name = "setframerate", .fmt = "i",
           .handler = RHANDLER(name, args, { gl->rate = *(int*) args[0]; })                 },
+        { .name = "setframebudget", .fmt = "f",
+          .handler = RHANDLER(name, args, { gl->gov.budget = *(float*) args[0] / 1000.0F; }) },
+        { .name = "setpolicy", .fmt = "siib",
+          .handler = RHANDLER(name, args, {
+                  int state = policy_lookup((const char*) args[0]);
+                  if (state == POLICY_NONE) {
+                      fprintf(stderr, "Invalid policy state: '%s', valid states are"
+                              " \"battery\" and \"load\"\n", (const char*) args[0]);
+                      glava_abort();
+                  }
+                  if (*(int*) args[2] < 1) {
+                      fprintf(stderr, "Invalid policy buffer scale: %d, must be at least 1\n",
+                              *(int*) args[2]);
+                      glava_abort();
+                  }
+                  gl->policy.states[state].set         = true;
+                  gl->policy.states[state].rate        = *(int*)  args[1];
+                  gl->policy.states[state].bufscale    = *(int*)  args[2];
+                  gl->policy.states[state].interpolate = *(bool*) args[3];
+              })
+        },
+        { .name = "setloadthreshold", .fmt = "f",
+          .handler = RHANDLER(name, args, { gl->policy.load_threshold = *(float*) args[0]; }) },
+        { .name = "setpowersupplypath", .fmt = "s",
+          .handler = RHANDLER(name, args, {
+                  if (gl->policy.path) free(gl->policy.path);
+                  gl->policy.path = strdup((const char*) args[0]);
+              })
+        },
         { .name = "setprintframes", .fmt = "b",
           .handler = RHANDLER(name, args, { gl->print_fps = *(bool*) args[0]; })           },
         { .name = "settitle", .fmt = "s",
@@ -1308,6 +1899,25 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                       .gr              = { .out = NULL },
                       .optimize_fft    = false
                   };
+                  /* per-frame globals may be read from the frame block instead */
+                  const char* member = NULL, * type = NULL;
+                  switch (src->src_type) {
+                      case SRC_SCREEN:   member = "_FRAME_SCREEN";   type = "ivec2"; break;
+                      case SRC_TIME:     member = "_FRAME_TIME";     type = "float"; break;
+                      case SRC_AUDIO_SZ: member = "_FRAME_AUDIO_SZ"; type = "int";   break;
+                  }
+                  if (member) {
+                      ++gl->frame_binds_sz;
+                      gl->frame_binds = realloc(gl->frame_binds,
+                                                gl->frame_binds_sz * sizeof(struct frame_bind));
+                      gl->frame_binds[gl->frame_binds_sz - 1] = (struct frame_bind) {
+                          .name   = current->binds[current->binds_sz - 1].name,
+                          .member = member,
+                          .type   = type,
+                          .sized  = src->src_type == SRC_SCREEN,
+                          .stage  = current
+                      };
+                  }
               })
         },
         { .name = NULL }
@@ -1413,11 +2023,6 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     }
 
     {
-        struct glsl_ext ext = {
-            .cd         = data,
-            .handlers   = handlers
-        };
-        
         const char* req;
         char fbuf[64];
         int idx = 1;
@@ -1426,10 +2031,16 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
             char* rbuf = malloc(rlen);
             rlen = snprintf(rbuf, rlen, "#request %s", req);
             snprintf(fbuf, sizeof(fbuf), "[request arg %d]", idx);
-            ext.source     = rbuf;
-            ext.source_len = rlen;
+            /* `ext_free` does not reset the state, so each request needs a new one */
+            struct glsl_ext ext = {
+                .source     = rbuf,
+                .source_len = rlen,
+                .cd         = data,
+                .handlers   = handlers
+            };
             ext_process(&ext, fbuf);
             ext_free(&ext);
+            free(rbuf);
             ++idx;
         }
     }
@@ -1469,6 +2080,8 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
     
+    setup_frame_block(gl);
+    
     size_t m_len = strlen(module);
     size_t bsz = d_len + m_len + 2;
     char shaders[bsz]; /* module pack path to use */
@@ -1482,8 +2095,8 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     /* Iterate through shader passes in the shader directory and build textures, framebuffers, and
        shader programs with each fragment shader. */
     
-    struct gl_sfbo* stages = NULL;
-    size_t count = 0;
+    struct gl_sfbo* stages = NULL, * columns = NULL;
+    size_t count = 0, columns_sz = 0;
     
     {
         char buf[32];
@@ -1513,12 +2126,8 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                 ++idx;
             } while (found);
         
-            stages = malloc(sizeof(struct gl_sfbo) * count);
-
-            size_t pipe_binds_len = 0;
-
-            for (struct rd_bind* bd = gl->binds; bd->name != NULL; ++bd)
-                ++pipe_binds_len;
+            stages  = malloc(sizeof(struct gl_sfbo) * count);
+            columns = calloc(count, sizeof(struct gl_sfbo));
         
             idx = 1;
             do {
@@ -1538,55 +2147,116 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                                 .indirect      = false,
                                 .nativeonly    = false,
                                 .binds         = malloc(1),
-                                .binds_sz      = 0,
-                                .pipe_uniforms = malloc(sizeof(GLuint) * pipe_binds_len)
+                                .binds_sz      = 0
                             };
 
                             current = s;
                             bool skip;
-                            GLuint id = shaderbuild(gl, shaders, data, dd,
-                                                    handlers, shader_version, &skip, d->d_name);
+                            GLuint id = shaderbuild(gl, shaders, data, dd, handlers, shader_version,
+                                                    &skip, &s->vertex_src, d->d_name);
                             if (skip && verbose) printf("disabled: '%s'\n", d->d_name);
                             /* check for compilation failure */
                             if (!id && !skip)
                                 glava_abort();
 
                             s->shader = id;
+                            
+                            if (s->vertex_src) {
+                                free(s->vertex_src);
+                                s->vertex_src = NULL;
+                            }
 
-                            if (id) {
-                                /* Only setup a framebuffer and texture if this isn't the final step,
-                                   as it can rendered directly */
-                                if (idx != count) {
-                                    int w, h;
-                                    gl->wcb->get_fbsize(gl->w, &w, &h);
-                                    setup_sfbo(&stages[idx - 1], w, h);
-                                }
-                                
-                                glUseProgram(id);
+                            /* Render targets for indirect stages are assigned once all stages
+                               are loaded, see below */
+                            if (id) setup_stage_uniforms(gl, s);
+
+                            /* Rebuild the previous stage with this stage's statement appended,
+                               and disable this stage, if it can be folded */
+                            struct gl_sfbo* target;
+                            if (id && s->fold_src && (target = fold_target(gl, stages, idx - 1))) {
+                                size_t e_len = target->epilogue ? strlen(target->epilogue) : 0;
+                                size_t f_len = strlen(s->fold_src);
+                                char* epilogue = malloc(e_len + f_len + 6);
+                                snprintf(epilogue, e_len + f_len + 6, "%s    %s\n",
+                                         target->epilogue ? target->epilogue : "", s->fold_src);
                                 
-                                /* Setup uniform bindings */
-                                size_t b;
-                                for (b = 0; b < s->binds_sz; ++b) {
-                                    s->binds[b].uniform = glGetUniformLocation(id, s->binds[b].name);
-                                }
-                                if (gl->stdin_type != STDIN_TYPE_NONE) {
-                                    s->stdin_uniform = glGetUniformLocation(id, "STDIN");
+                                /* Requests are handled again while rebuilding, so they are
+                                   applied to a copy of the stage and discarded */
+                                struct gl_sfbo copy = *target;
+                                copy.binds      = malloc(1);
+                                copy.binds_sz   = 0;
+                                copy.vertex_src = NULL;
+                                copy.column_src = NULL;
+                                copy.fold_src   = NULL;
+                                current      = &copy;
+                                gl->epilogue = epilogue;
+                                GLuint fid = shaderbuild(gl, shaders, data, dd, handlers, shader_version,
+                                                         NULL, &copy.vertex_src, target->name);
+                                gl->epilogue = NULL;
+                                current      = s;
+                                for (size_t b = 0; b < copy.binds_sz; ++b) {
+                                    free(copy.binds[b].transformations);
+                                    free((char*) copy.binds[b].name);
                                 }
-                                size_t u = 0;
-                                for (struct rd_bind* bd = gl->binds; bd->name != NULL; ++bd) {
-                                    char buf[128];
-                                    if (snprintf(buf, 128, "_IN_%s", bd->name) > 0) {
-                                        s->pipe_uniforms[u] = glGetUniformLocation(id, buf);
-                                    } else {
-                                        fprintf(stderr, "failed to format binding: \"%s\"\n", bd->name);
+                                free(copy.binds);
+                                if (copy.vertex_src) free(copy.vertex_src);
+                                if (copy.column_src) free(copy.column_src);
+                                if (copy.fold_src)   free(copy.fold_src);
+                                
+                                if (fid) {
+                                    if (verbose) printf("folded '%s' into '%s'\n", s->name, target->name);
+                                    glDeleteProgram(target->shader);
+                                    target->shader = fid;
+                                    if (target->epilogue) free(target->epilogue);
+                                    target->epilogue = epilogue;
+                                    setup_stage_uniforms(gl, target);
+                                    glDeleteProgram(id);
+                                    s->shader = id = 0;
+                                } else free(epilogue);
+                            }
+                            if (s->fold_src) {
+                                free(s->fold_src);
+                                s->fold_src = NULL;
+                            }
+
+                            /* Compile the column pass requested by this stage, if any */
+                            if (s->column_src) {
+                                if (id) {
+                                    if (verbose) printf("compiling column: '%s'\n", s->column_src);
+
+                                    struct gl_sfbo* col = &columns[idx - 1];
+                                    *col = (struct gl_sfbo) {
+                                        .name          = strdup(s->column_src),
+                                        .shader        = 0,
+                                        .indirect      = false,
+                                        .nativeonly    = false,
+                                        .column        = true,
+                                        .format        = lookup_sfbo_format("rgba32f"),
+                                        .binds         = malloc(1),
+                                        .binds_sz      = 0
+                                    };
+                                    ++columns_sz;
+
+                                    current = col;
+                                    GLuint cid = shaderbuild(gl, shaders, data, dd, handlers, shader_version,
+                                                             &skip, NULL, col->name);
+                                    if (skip && verbose) printf("disabled: '%s'\n", col->name);
+                                    if (!cid && !skip)
                                         glava_abort();
+
+                                    col->shader = cid;
+
+                                    if (cid) {
+                                        int w, h;
+                                        gl->wcb->get_fbsize(gl->w, &w, &h);
+                                        setup_sfbo(col, w, h);
+                                        setup_stage_uniforms(gl, col);
                                     }
-                                    ++u;
                                 }
-                                glBindFragDataLocation(id, 1, "fragment");
-                                glUseProgram(0);
+                                free(s->column_src);
+                                s->column_src = NULL;
                             }
-                        
+
                             found = true;
                         }
                     }
@@ -1597,14 +2267,30 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         }
     }
     
+    /* Column passes are rendered immediately before the stage that requested them */
+    if (columns_sz > 0) {
+        struct gl_sfbo* merged = malloc(sizeof(struct gl_sfbo) * (count + columns_sz));
+        size_t m = 0;
+        for (size_t t = 0; t < count; ++t) {
+            if (columns[t].column)
+                merged[m++] = columns[t];
+            merged[m++] = stages[t];
+        }
+        free(stages);
+        stages = merged;
+        count += columns_sz;
+    }
+    free(columns);
+    
     gl->stages = stages;
     gl->stages_sz = count;
     
     if (gl->test_mode || gl->wcb->offscreen()) {
         int w, h;
         gl->wcb->get_fbsize(gl->w, &w, &h);
-        setup_sfbo(&gl->off_sfbo, w, h);
-        r->off_tex = gl->off_sfbo.tex;
+        setup_sfbo(&gl->off_sfbo[0], w, h);
+        setup_sfbo(&gl->off_sfbo[1], w, h);
+        r->off_tex = gl->off_sfbo[0].tex;
         r->flag = true; 
         pthread_cond_signal(&r->cond);
         pthread_mutex_unlock(&r->lock);
@@ -1613,12 +2299,52 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     {
         struct gl_sfbo* final = NULL;
         for (size_t t = 0; t < gl->stages_sz; ++t) {
-            if (gl->stages[t].shader && (gl->premultiply_alpha || !gl->stages[t].nativeonly)) {
+            if (gl->stages[t].shader && !gl->stages[t].column
+                && (gl->premultiply_alpha || !gl->stages[t].nativeonly)) {
                 final = &gl->stages[t];
             }
         }
         /* Use dirct rendering on final pass */
         if (final) final->indirect = false;
+        
+        /* Assign render targets to the remaining stages. A stage's output is only read by the
+           next stage that is drawn (as `prev`), so targets can be shared by any stages that
+           do not read from each other. This usually results in two targets, used alternately,
+           regardless of how many stages the module has. Stages are only assigned targets of the
+           same format and scale; the final stage always renders at full size. Decimated stages
+           are given their own target, since their output is kept between updates. */
+        int w, h;
+        gl->wcb->get_fbsize(gl->w, &w, &h);
+        gl->targets    = NULL;
+        gl->targets_sz = 0;
+        size_t last = SIZE_MAX; /* target read by the stage being assigned */
+        for (size_t t = 0; t < gl->stages_sz; ++t) {
+            struct gl_sfbo* s = &gl->stages[t];
+            if (!s->shader || s->column || (s->nativeonly && !gl->premultiply_alpha))
+                continue;
+            if (s == final)
+                break;
+            const struct sfbo_format* f = s->format ? s->format : &sfbo_formats[0];
+            size_t u;
+            for (u = 0; u < gl->targets_sz && !DECIMATED(s); ++u) {
+                if (u != last && gl->targets[u].format == f && gl->targets[u].scale == s->scale
+                    && !DECIMATED(&gl->targets[u]))
+                    break;
+            }
+            if (u == gl->targets_sz) {
+                gl->targets = realloc(gl->targets, ++gl->targets_sz * sizeof(struct gl_sfbo));
+                gl->targets[u] = (struct gl_sfbo) {
+                    .indirect = false, .format = f, .scale = s->scale,
+                    .interval = s->interval, .rate = s->rate
+                };
+                setup_sfbo(&gl->targets[u], w, h);
+            }
+            s->fbo      = gl->targets[u].fbo;
+            s->tex      = gl->targets[u].tex;
+            s->indirect = true;
+            last        = u;
+        }
+        if (verbose) printf("using %d render target(s) for indirect stages\n", (int) gl->targets_sz);
     }
     
     /* Compile various audio processing shaders */
@@ -1633,7 +2359,7 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         /* Compile smooth pass shader */
         loading_smooth_pass = true;
         if (!(gl->sm_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
-                                        NULL, "smooth_pass.frag")))
+                                        NULL, NULL, "smooth_pass.frag")))
             glava_abort();
         gl->sm_utex = glGetUniformLocation(gl->sm_prog, "tex");
         gl->sm_usz  = glGetUniformLocation(gl->sm_prog, "sz");
@@ -1641,17 +2367,38 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
         glBindFragDataLocation(gl->sm_prog, 1, "fragment");
         loading_smooth_pass = false;
         
+        /* Compile prefix sum pass shader */
+        if (!(gl->ps_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
+                                        NULL, NULL, "psum_pass.frag")))
+            glava_abort();
+        gl->ps_utex  = glGetUniformLocation(gl->ps_prog, "tex");
+        gl->ps_ustep = glGetUniformLocation(gl->ps_prog, "step");
+        
+        /* Compile pass shader (straight 1D texture map) */
+        if (!(gl->p_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
+                                       NULL, NULL, "pass.frag")))
+            glava_abort();
+        gl->p_utex  = glGetUniformLocation(gl->p_prog, "tex");
+        
+        /* Compile keyframe interpolation shader */
+        if (!(gl->kf_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
+                                        NULL, NULL, "interpolate.frag")))
+            glava_abort();
+        gl->kf_ut0     = glGetUniformLocation(gl->kf_prog, "t0");
+        gl->kf_ut1     = glGetUniformLocation(gl->kf_prog, "t1");
+        gl->kf_ufactor = glGetUniformLocation(gl->kf_prog, "factor");
+        
         if (gl->accel_fft) {
             /* Compile gravity pass shader */
             if (!(gl->gr_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
-                                            NULL, "gravity_pass.frag")))
+                                            NULL, NULL, "gravity_pass.frag")))
                 glava_abort();
             gl->gr_utex  = glGetUniformLocation(gl->gr_prog, "tex");
             gl->gr_udiff = glGetUniformLocation(gl->gr_prog, "diff");
         
             /* Compile averaging shader */
             if (!(gl->av_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
-                                            NULL, "average_pass.frag")))
+                                            NULL, NULL, "average_pass.frag")))
                 glava_abort();
             char buf[6];
             gl->av_utex = malloc(sizeof(GLuint) * gl->avg_frames);
@@ -1659,12 +2406,6 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
                 snprintf(buf, sizeof(buf), "t%d", (int) t);
                 gl->av_utex[t] = glGetUniformLocation(gl->av_prog, buf);
             }
-        
-            /* Compile pass shader (straight 1D texture map) */
-            if (!(gl->p_prog = shaderbuild(gl, util, data, dd, handlers, shader_version,
-                                           NULL, "pass.frag")))
-                glava_abort();
-            gl->p_utex  = glGetUniformLocation(gl->p_prog, "tex");
         }
     }
 
@@ -1676,19 +2417,6 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     gl->audio_tex_r = create_1d_tex();
     gl->audio_tex_l = create_1d_tex();
     
-    if (gl->interpolate) {
-        /* Allocate six buffers at once */
-        size_t isz = (r->bufsize_request / gl->bufscale);
-        float* ibuf = malloc(isz * 6 * sizeof(float));
-        
-        gl->interpolate_buf[IB_START_LEFT ] = &ibuf[isz * IB_START_LEFT ]; /* left channel keyframe start  */
-        gl->interpolate_buf[IB_END_LEFT   ] = &ibuf[isz * IB_END_LEFT   ]; /* left channel keyframe end    */
-        gl->interpolate_buf[IB_START_RIGHT] = &ibuf[isz * IB_START_RIGHT]; /* right channel keyframe start */
-        gl->interpolate_buf[IB_END_RIGHT  ] = &ibuf[isz * IB_END_RIGHT  ]; /* right channel keyframe end   */
-        gl->interpolate_buf[IB_WORK_LEFT  ] = &ibuf[isz * IB_WORK_LEFT  ]; /* left interpolation results   */
-        gl->interpolate_buf[IB_WORK_RIGHT ] = &ibuf[isz * IB_WORK_RIGHT ]; /* right interpolation results  */
-    }
-    
     gl->t_data  = malloc(sizeof(void*) * t_count);
     gl->t_count = t_count;
     for (size_t t = 0; t < t_count; ++t) {
@@ -1697,6 +2425,13 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
 
     overlay(&gl->overlay);
     
+    /* Settings that policies and the governor may change */
+    gl->policy.rate     = gl->gov.rate     = gl->rate;
+    gl->policy.bufscale = gl->gov.bufscale = gl->bufscale;
+    if (!gl->policy.path)
+        gl->policy.path = strdup(POLICY_POWER_SUPPLY_PATH);
+    gl->policy.checked = -POLICY_INTERVAL; /* check on the first second */
+    
     glClearColor(gl->clear_color.r, gl->clear_color.g, gl->clear_color.b, gl->clear_color.a);
     
     gl->wcb->set_visible(gl->w, true);
@@ -1704,21 +2439,23 @@ struct glava_renderer* rd_new(const char**    paths,        const char* entry,
     return r;
 }
 
-static void bind_1d_fbo(struct sm_fb* sm, size_t sz) {
+static void bind_1d_fbo(struct gl_data* gl, struct sm_fb* sm, size_t sz, GLint format) {
     if (sm->tex == 0) {
         glGenTextures(1, &sm->tex);
         glGenFramebuffers(1, &sm->fbo);
 
-        /* 1D texture parameters */
-        glBindTexture(GL_TEXTURE_1D, sm->tex);
+        /* 1D texture parameters; bound without DSA, since the texture has no target yet */
+        st_active(gl, 0);
+        glBindTexture(GL_TEXTURE_1D, gl->st.tex_1d[0] = sm->tex);
         glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexImage1D(GL_TEXTURE_1D, 0, GL_R16, sz, 0, GL_RED, GL_FLOAT, NULL);
+        glTexImage1D(GL_TEXTURE_1D, 0, format, sz, 0, GL_RED, GL_FLOAT, NULL);
+        sm->sz = sz;
     
         /* setup and bind framebuffer to texture */
-        glBindFramebuffer(GL_FRAMEBUFFER, sm->fbo);
+        st_fbo(gl, sm->fbo);
         glFramebufferTexture1D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,\
                                GL_TEXTURE_1D, sm->tex, 0);
                         
@@ -1729,9 +2466,316 @@ static void bind_1d_fbo(struct sm_fb* sm, size_t sz) {
                 glava_abort();
         }
     } else {
+        /* Reallocate if the buffer size was changed at runtime (ie. by `setbufscale`) */
+        if (sm->sz != sz) {
+            st_active(gl, 0);
+            glBindTexture(GL_TEXTURE_1D, gl->st.tex_1d[0] = sm->tex);
+            glTexImage1D(GL_TEXTURE_1D, 0, format, sz, 0, GL_RED, GL_FLOAT, NULL);
+            sm->sz = sz;
+        }
         /* Just bind our data if it was already allocated and setup */
-        glBindFramebuffer(GL_FRAMEBUFFER, sm->fbo);
+        st_fbo(gl, sm->fbo);
+    }
+}
+
+/* Store the processed audio texture `tex` as the most recent interpolation keyframe, replacing
+   the oldest one. The first keyframe fills both slots. */
+static void push_keyframe(struct gl_data* gl, struct gl_bind* bind, GLuint tex, int offset, size_t sz) {
+    st_program(gl, gl->p_prog);
+    st_texture(gl, offset, GL_TEXTURE_1D, tex);
+    st_uniform1i(gl, gl->p_prog, gl->p_utex, offset);
+    st_blend(gl, false);
+    st_viewport(gl, sz, 1);
+    if (bind->key[bind->key_idx].sz != sz)
+        bind->keyed = false; /* resized, both keyframes are replaced */
+    for (int t = bind->keyed ? 1 : 2; t > 0; --t) {
+        bind->key_idx ^= 1;
+        bind_1d_fbo(gl, &bind->key[bind->key_idx], sz, GL_R16);
+        drawoverlay(gl);
+    }
+    bind->keyed = true;
+}
+
+/* Blend between the last two keyframes, returning the resulting texture. Either keyframe is
+   returned as-is if no blending is required. */
+static GLuint mix_keyframes(struct gl_data* gl, struct gl_bind* bind, int offset, size_t sz, float factor) {
+    if (factor <= 0.0F) return bind->key[bind->key_idx ^ 1].tex;
+    if (factor >= 1.0F) return bind->key[bind->key_idx].tex;
+    bind_1d_fbo(gl, &bind->key_mix, sz, GL_R16);
+    st_program(gl, gl->kf_prog);
+    st_texture(gl, offset, GL_TEXTURE_1D, bind->key[bind->key_idx ^ 1].tex);
+    st_texture(gl, KEYFRAME_TEXTURE_UNIT, GL_TEXTURE_1D, bind->key[bind->key_idx].tex);
+    st_uniform1i(gl, gl->kf_prog, gl->kf_ut0, offset);
+    st_uniform1i(gl, gl->kf_prog, gl->kf_ut1, KEYFRAME_TEXTURE_UNIT);
+    st_uniform1f(gl, gl->kf_prog, gl->kf_ufactor, factor);
+    st_blend(gl, false);
+    st_viewport(gl, sz, 1);
+    drawoverlay(gl);
+    return bind->key_mix.tex;
+}
+
+static void decimator_free(struct decimator* dec) {
+    free(dec->coeffs);
+    free(dec->ring[0]);
+    free(dec->work[0]);
+    *dec = (struct decimator) { .factor = 0 };
+}
+
+/* Filter `buf` for the output at input index `i`, clamping to the start of the buffer */
+static float decimate_at(struct decimator* dec, const float* buf, ssize_t i) {
+    typedef float v4f __attribute__((vector_size(16)));
+    ssize_t start = i + 1 - (ssize_t) dec->taps;
+    if (start < 0) {
+        float accum = 0.0F;
+        for (size_t k = 0; k < dec->taps; ++k)
+            accum += dec->coeffs[k] * buf[start + (ssize_t) k < 0 ? 0 : start + (ssize_t) k];
+        return accum;
+    }
+    v4f accum = { 0.0F, 0.0F, 0.0F, 0.0F }, x, h;
+    for (size_t k = 0; k < dec->taps; k += 4) {
+        memcpy(&x, &buf[start + k], sizeof(x));
+        memcpy(&h, &dec->coeffs[k], sizeof(h));
+        accum += x * h;
+    }
+    return accum[0] + accum[1] + accum[2] + accum[3];
+}
+
+/* Append the output for input index `i` of each channel to the ring */
+static void decimate_push(struct decimator* dec, const float* lb, const float* rb, ssize_t i) {
+    for (int c = 0; c < 2; ++c) {
+        float v = decimate_at(dec, c ? rb : lb, i);
+        dec->ring[c][dec->head] = dec->ring[c][dec->head + dec->out_sz] = v;
+    }
+    if (++dec->head >= dec->out_sz)
+        dec->head = 0;
+}
+
+/* Decimate the `fresh` samples at the end of `lb` and `rb` by `factor`. The ring is rebuilt
+   from the whole buffer if the configuration changed, or if too many samples were missed to
+   filter only the new ones. */
+static void decimate(struct decimator* dec, const float* lb, const float* rb,
+                     size_t sz, size_t fresh, size_t factor) {
+    if (dec->factor != factor || dec->in_sz != sz) {
+        decimator_free(dec);
+        dec->factor = factor;
+        dec->in_sz  = sz;
+        dec->taps   = factor * DECIMATE_TAPS;
+        dec->out_sz = sz / factor;
+        dec->coeffs = malloc(dec->taps * sizeof(float));
+        float* ring = malloc(dec->out_sz * 4 * sizeof(float));
+        float* work = malloc(dec->out_sz * 2 * sizeof(float));
+        dec->ring[0] = ring;
+        dec->ring[1] = ring + dec->out_sz * 2;
+        dec->work[0] = work;
+        dec->work[1] = work + dec->out_sz;
+        
+        /* Blackman windowed sinc, cut off at the Nyquist frequency of the output rate */
+        double sum = 0.0, mid = (dec->taps - 1) / 2.0, fc = 0.5 / factor;
+        for (size_t k = 0; k < dec->taps; ++k) {
+            double x = k - mid, w = (2 * M_PI * k) / (dec->taps - 1);
+            double h = 2 * fc * (x == 0.0 ? 1.0 : sin(2 * M_PI * fc * x) / (2 * M_PI * fc * x));
+            h *= 0.42 - 0.5 * cos(w) + 0.08 * cos(2 * w);
+            dec->coeffs[k] = (float) h;
+            sum += h;
+        }
+        for (size_t k = 0; k < dec->taps; ++k)
+            dec->coeffs[k] /= (float) sum;
+        fresh = sz;
+    }
+    if (fresh == 0)
+        return;
+    if (fresh + dec->taps > sz) {
+        /* Rebuild the ring, ending with an output at the newest sample */
+        dec->head  = 0;
+        dec->phase = 0;
+        for (size_t t = 0; t < dec->out_sz; ++t)
+            decimate_push(dec, lb, rb, (ssize_t) (sz - 1 - (dec->out_sz - 1 - t) * factor));
+        return;
     }
+    /* Only filter at the positions of new samples that complete an output */
+    for (size_t i = sz - fresh + (factor - 1 - dec->phase); i < sz; i += factor)
+        decimate_push(dec, lb, rb, (ssize_t) i);
+    dec->phase = (dec->phase + fresh) % factor;
+}
+
+/* Draw our section of the desktop background into the bound framebuffer */
+static void drawbackground(struct gl_data* gl, int ww, int wh) {
+    /* Shader to map our section of the background (flipping the texture if needed) and
+       override alpha channel. This is embedded since we don't need any GLSL
+       preprocessing here */
+    static const char* frag_shader =
+        "uniform sampler2D tex;"                                                             "\n"
+        "uniform ivec2 offset;"                                                              "\n"
+        "uniform int flip;"                                                                  "\n"
+        "out vec4 fragment;"                                                                 "\n"
+        "in vec4 gl_FragCoord;"                                                              "\n"
+        "void main() {"                                                                      "\n"
+        "    fragment = texelFetch(tex, ivec2(offset.x + gl_FragCoord.x, "                   "\n"
+        "                       offset.y + flip * gl_FragCoord.y), 0);"                      "\n"
+        "    fragment.a = 1.0F;"                                                             "\n"
+        "}"                                                                                  "\n";
+    if (!gl->bg_setup) {
+        gl->bg_prog = shaderlink(shaderload(NULL, GL_VERTEX_SHADER, VERTEX_SHADER_SRC,
+                                            NULL, NULL, NULL, 330, true, NULL, gl),
+                                 shaderload(NULL, GL_FRAGMENT_SHADER, frag_shader,
+                                            NULL, NULL, NULL, 330, true, NULL, gl));
+        gl->bg_utex    = glGetUniformLocation(gl->bg_prog, "tex");
+        gl->bg_uoffset = glGetUniformLocation(gl->bg_prog, "offset");
+        gl->bg_uflip   = glGetUniformLocation(gl->bg_prog, "flip");
+        glBindFragDataLocation(gl->bg_prog, 1, "fragment");
+        gl->bg_setup = true;
+    }
+    st_program(gl, gl->bg_prog);
+    st_texture(gl, 0, GL_TEXTURE_2D, gl->bg_view);
+    glUniform2i(gl->bg_uoffset, gl->bg_offset[0], gl->bg_offset[1]);
+    glUniform1i(gl->bg_uflip, gl->bg_flip);
+    glUniform1i(gl->bg_utex, 0);
+    /* We need to disable blending, we might read in bogus alpha values due
+       to how we obtain the background texture (format is four byte `rgb_`, 
+       where the last value is skipped) */
+    st_blend(gl, false);
+    st_viewport(gl, ww, wh);
+    drawoverlay(gl);
+}
+
+/* Report a frame that could not be read back; lossless readback cannot continue without it */
+static void readback_lost(struct glava_renderer* r, uint64_t seq, const char* reason) {
+    fprintf(stderr, "Failed to read back frame %llu: %s\n", (unsigned long long) seq, reason);
+    if (r->readback.lossless)
+        glava_abort();
+}
+
+/* Deliver finished readbacks in order, only waiting while more than `max_pending` are in flight */
+static void readback_collect(struct glava_renderer* r, size_t max_pending) {
+    struct readback* rb = &r->gl->rb;
+    int waited = 0; /* seconds spent waiting for the oldest readback */
+    while (rb->pending > 0) {
+        struct readback_slot* slot = &rb->slots[rb->tail];
+        bool wait = rb->pending > max_pending;
+        GLenum status = glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         wait ? 1000000000 : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            if (!wait)
+                break;
+            if (++waited < READBACK_TIMEOUT)
+                continue;
+            status = GL_WAIT_FAILED; /* the context is likely hung or lost */
+        }
+        waited = 0;
+        glDeleteSync(slot->fence);
+        slot->fence = NULL;
+        rb->tail = (rb->tail + 1) % READBACK_RING;
+        --rb->pending;
+        if (status == GL_WAIT_FAILED) {
+            readback_lost(r, slot->seq, "timed out or failed waiting for the GPU");
+            continue;
+        }
+        
+        size_t sz = (size_t) slot->w * slot->h * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+        const unsigned char* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sz, GL_MAP_READ_BIT);
+        if (!pixels) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            readback_lost(r, slot->seq, "could not map the pixel buffer");
+            continue;
+        }
+        pthread_mutex_lock(&r->readback.lock);
+        glava_frame_cb cb = r->readback.cb;
+        void* user        = r->readback.user;
+        if (cb) {
+            /* Not invoked with the lock held, so a slow callback does not block other callers */
+            pthread_mutex_unlock(&r->readback.lock);
+            cb(pixels, slot->w, slot->h, slot->seq, user);
+        } else {
+            if (r->readback.sz != sz) {
+                r->readback.data = realloc(r->readback.data, sz);
+                r->readback.sz   = sz;
+            }
+            memcpy(r->readback.data, pixels, sz);
+            r->readback.w   = slot->w;
+            r->readback.h   = slot->h;
+            r->readback.seq = slot->seq;
+            pthread_mutex_unlock(&r->readback.lock);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+/* Start reading back the bound framebuffer, dropping the frame if no buffer is available
+   (or waiting for one, if lossless) */
+static void readback_frame(struct glava_renderer* r, int w, int h) {
+    struct readback* rb = &r->gl->rb;
+    uint64_t seq = ++rb->frames;
+    if (rb->pending == READBACK_RING) {
+        if (!r->readback.lossless)
+            return;
+        readback_collect(r, READBACK_RING - 1);
+    }
+    
+    struct readback_slot* slot = &rb->slots[(rb->tail + rb->pending) % READBACK_RING];
+    size_t sz = (size_t) w * h * 4;
+    if (!slot->pbo)
+        glGenBuffers(1, &slot->pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    if (slot->sz != sz) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, sz, NULL, GL_STREAM_READ);
+        slot->sz = sz;
+    }
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->w     = w;
+    slot->h     = h;
+    slot->seq   = seq;
+    ++rb->pending;
+}
+
+static void readback_free(struct readback* rb) {
+    for (size_t t = 0; t < READBACK_RING; ++t) {
+        if (rb->slots[t].fence)
+            glDeleteSync(rb->slots[t].fence);
+        if (rb->slots[t].pbo)
+            glDeleteBuffers(1, &rb->slots[t].pbo);
+    }
+    /* keep counting frames, so sequence numbers stay increasing if readback is enabled again */
+    *rb = (struct readback) { .frames = rb->frames };
+}
+
+/* Offscreen output is double buffered, so frames can be sampled from another context (see
+   `glava_acquire`) while the next one is drawn. Select the buffer that does not hold the latest
+   frame for drawing, waiting only if a consumer is still recording commands that sample it.
+   Reads already submitted by the consumer are ordered on the GPU with its release fence. */
+static int off_begin(struct glava_renderer* r) {
+    struct gl_data* gl = r->gl;
+    pthread_mutex_lock(&r->lock);
+    int back = !r->out.front;
+    while (r->out.held == back)
+        pthread_cond_wait(&r->cond, &r->lock);
+    if (r->out.done[back]) {
+        glWaitSync(r->out.done[back], 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(r->out.done[back]);
+        r->out.done[back] = NULL;
+    }
+    if (r->out.ready[back]) {
+        glDeleteSync(r->out.ready[back]);
+        r->out.ready[back] = NULL;
+    }
+    pthread_mutex_unlock(&r->lock);
+    return gl->off_cur = back;
+}
+
+/* Publish the buffer drawn this frame as the latest complete frame */
+static void off_publish(struct glava_renderer* r) {
+    struct gl_data* gl = r->gl;
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); /* fences are only visible to other contexts once flushed */
+    pthread_mutex_lock(&r->lock);
+    r->out.front = gl->off_cur;
+    r->out.ready[gl->off_cur] = fence;
+    ++r->out.seq;
+    r->off_tex = gl->off_sfbo[gl->off_cur].tex;
+    pthread_mutex_unlock(&r->lock);
 }
 
 void rd_time(struct glava_renderer* r) {
@@ -1740,73 +2784,181 @@ void rd_time(struct glava_renderer* r) {
     gl->wcb->set_time(gl->w, 0.0); /* reset time for measuring this frame */
 }
 
-bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool modified) {
+/* Quality governor, enabled with `#request setframebudget`. Once per second, the average time
+   taken by presented frames is compared against the budget. Quality is reduced one step at a
+   time while over budget, and restored one step at a time once there has been enough headroom
+   for a few seconds. Steps are applied in order: */
+
+#define GOV_INTERPOLATE 1 /* disable interpolation                                    */
+#define GOV_BUFSCALE    2 /* halve the audio buffer passed to shaders                 */
+#define GOV_STAGE_SCALE 3 /* halve the resolution of stages that are already reduced  */
+#define GOV_FRAMERATE   4 /* limit the framerate to half of the measured rate         */
+#define GOV_MAX         GOV_FRAMERATE
+
+#define GOV_HEADROOM 0.6F /* fraction of the budget frames must stay under to step up */
+#define GOV_RECOVER  3    /* seconds of headroom needed to step up                    */
+
+/* Multiply or divide the scale of reduced size stages and their targets, returning false if
+   there are no such stages */
+static bool gov_stage_scale(struct gl_data* gl, bool reduce) {
+    bool found = false;
+    for (size_t t = 0; t < gl->stages_sz; ++t) {
+        struct gl_sfbo* s = &gl->stages[t];
+        if (s->scale > 1 && !s->column) {
+            s->scale = reduce ? s->scale * 2 : s->scale / 2;
+            found = true;
+        }
+    }
+    for (size_t t = 0; t < gl->targets_sz; ++t) {
+        struct gl_sfbo* s = &gl->targets[t];
+        if (s->scale > 1)
+            s->scale = reduce ? s->scale * 2 : s->scale / 2;
+    }
+    if (found)
+        gl->lww = -1; /* reallocate render targets on the next frame */
+    return found;
+}
+
+/* Apply or revert the next step, returning false if it does not apply to this configuration */
+static bool gov_step(struct gl_data* gl, bool reduce, bool interpolate) {
+    int level = reduce ? gl->gov.level + 1 : gl->gov.level;
+    gl->gov.level = reduce ? level : level - 1;
+    switch (level) {
+        case GOV_INTERPOLATE:
+            if (!interpolate) return false;
+            printf("governor: %s interpolation\n", reduce ? "disabling" : "restoring");
+            break;
+        case GOV_BUFSCALE:
+            gl->bufscale = reduce ? gl->gov.bufscale * 2 : gl->gov.bufscale;
+            printf("governor: %s audio buffer scale (%d)\n",
+                   reduce ? "increasing" : "restoring", (int) gl->bufscale);
+            break;
+        case GOV_STAGE_SCALE:
+            if (!gov_stage_scale(gl, reduce)) return false;
+            printf("governor: %s stage render scale\n", reduce ? "reducing" : "restoring");
+            break;
+        case GOV_FRAMERATE: {
+            int limit = (int) (gl->fr / 2.0F);
+            gl->rate = reduce ? (limit > 10 ? limit : 10) : gl->gov.rate;
+            if (reduce) printf("governor: limiting framerate to %d\n", gl->rate);
+            else if (gl->rate > 0) printf("governor: restoring framerate limit (%d)\n", gl->rate);
+            else printf("governor: removing framerate limit\n");
+            break;
+        }
+    }
+    return true;
+}
+
+static void gov_update(struct gl_data* gl, bool interpolate) {
+    if (gl->gov.frames == 0)
+        return;
+    float avg = (float) (gl->gov.work / gl->gov.frames);
+    if (avg > gl->gov.budget) {
+        gl->gov.recover = 0;
+        if (gl->gov.level < GOV_MAX) {
+            printf("governor: frame time %.2fms exceeds budget of %.2fms\n",
+                   (double) avg * 1000.0, (double) gl->gov.budget * 1000.0);
+            while (gl->gov.level < GOV_MAX && !gov_step(gl, true, interpolate));
+        }
+    } else if (avg < gl->gov.budget * GOV_HEADROOM && gl->gov.level > 0) {
+        if (++gl->gov.recover >= GOV_RECOVER) {
+            gl->gov.recover = 0;
+            printf("governor: frame time %.2fms is within budget of %.2fms\n",
+                   (double) avg * 1000.0, (double) gl->gov.budget * 1000.0);
+            while (gl->gov.level > 0 && !gov_step(gl, false, interpolate));
+        }
+    } else gl->gov.recover = 0;
+}
+
+/* Rendering policies override the framerate, audio buffer scale and interpolation settings for
+   system states configured with `#request setpolicy`. The system state is checked every
+   `POLICY_INTERVAL` seconds. */
+
+static void policy_apply(struct gl_data* gl, int state) {
+    int    rate     = state == POLICY_NONE ? gl->policy.rate     : gl->policy.states[state].rate;
+    size_t bufscale = state == POLICY_NONE ? gl->policy.bufscale : gl->policy.states[state].bufscale;
+    /* these become the values restored by the governor, and apply now unless overridden by it */
+    gl->gov.rate     = rate;
+    gl->gov.bufscale = bufscale;
+    if (gl->gov.level < GOV_FRAMERATE)
+        gl->rate = rate;
+    gl->bufscale = gl->gov.level >= GOV_BUFSCALE ? bufscale * 2 : bufscale;
+    gl->policy.state = state;
+}
+
+static void policy_update(struct gl_data* gl) {
+    int state = POLICY_NONE;
+    float load = 0.0F;
+    if (gl->policy.states[POLICY_LOAD].set && gl->policy.load_threshold > 0.0F
+        && (load = policy_load()) > gl->policy.load_threshold)
+        state = POLICY_LOAD;
+    else if (gl->policy.states[POLICY_BATTERY].set && policy_on_battery(gl->policy.path))
+        state = POLICY_BATTERY;
+    if (state == gl->policy.state)
+        return;
+    switch (state) {
+        case POLICY_LOAD:
+            printf("policy: system load %.2f exceeds threshold of %.2f, applying \"load\" policy\n",
+                   (double) load, (double) gl->policy.load_threshold);
+            break;
+        case POLICY_BATTERY:
+            printf("policy: running on battery power, applying \"battery\" policy\n");
+            break;
+        default:
+            printf("policy: restoring configured settings\n");
+            break;
+    }
+    policy_apply(gl, state);
+}
+
+bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz,
+               bool modified, size_t fresh) {
     struct gl_data* gl = r->gl;
-    size_t t, a, fbsz = bsz * sizeof(float);
+    size_t t, fbsz = bsz * sizeof(float);
     
     if (gl->wcb->should_close(gl->w)) {
         r->alive = false;
         return true;
     }
 
-    /* Stop rendering if the backend has some reason not to render (minimized, obscured) */
-    if (!gl->wcb->should_render(gl->w))
+    /* Stop rendering if the backend has some reason not to render (minimized, obscured). Offline
+       output needs a frame for every step of audio, whether or not the window is visible. */
+    if (!r->offline && !gl->wcb->should_render(gl->w))
         return false;
     
     /* Stop rendering when fullscreen windows are focused */
-    if (gl->check_fullscreen && !xwin_should_render(gl->wcb, gl->w))
+    if (!r->offline && gl->check_fullscreen && !xwin_should_render(gl->wcb, gl->w))
         return false;
 
+    /* Every offline frame is an update frame at a fixed rate, so the rates measured below (used
+       for gravity and interpolation) are known from the first frame */
+    if (r->offline)
+        gl->fr = gl->ur = (float) rd_get_offline_rate(r);
+    
     /* Force disable interpolation if the update rate is close to or higher than the frame rate */
     float uratio = (gl->ur / gl->fr); /* update : framerate ratio */
-    MUTABLE bool old_interpolate = gl->interpolate;
-    gl->interpolate = uratio <= 0.9F ? old_interpolate : false;
+    bool old_interpolate = gl->interpolate;
+    bool allow_interpolate = gl->gov.level < GOV_INTERPOLATE
+        && (gl->policy.state == POLICY_NONE || gl->policy.states[gl->policy.state].interpolate);
+    gl->interpolate = uratio <= 0.9F && allow_interpolate ? old_interpolate : false;
 
     /* Perform buffer scaling */
-    size_t nsz = gl->bufscale > 1 ? (bsz / gl->bufscale) : 0;
-    float nlb[nsz], nrb[nsz];
     if (gl->bufscale > 1) {
-        float accum;
-        for (t = 0; t < nsz; ++t) {
-            accum = 0.0F;
-            for (a = 0; a < gl->bufscale; ++a) {
-                accum += lb[(t * gl->bufscale) + a];
-            }
-            accum /= (float) gl->bufscale;
-            nlb[t] = accum;
-        }
-        for (t = 0; t < nsz; ++t) {
-            accum = 0.0F;
-            for (a = 0; a < gl->bufscale; ++a) {
-                accum += rb[(t * gl->bufscale) + a];
-            }
-            accum /= (float) gl->bufscale;
-            nrb[t] = accum;
-        }
-        lb = nlb;
-        rb = nrb;
-        bsz = nsz;
+        struct decimator* dec = &gl->dec;
+        decimate(dec, lb, rb, bsz, modified ? fresh : 0, gl->bufscale);
+        /* Transformations are applied in-place, so they are given a copy of the ring */
+        bsz  = dec->out_sz;
         fbsz = bsz * sizeof(float);
+        memcpy(dec->work[0], &dec->ring[0][dec->head], fbsz);
+        memcpy(dec->work[1], &dec->ring[1][dec->head], fbsz);
+        lb = dec->work[0];
+        rb = dec->work[1];
     }
 
-    /* Linear interpolation */
-    float * ilb = NULL, * irb = NULL;
-    if (gl->interpolate) {
-        ilb = gl->interpolate_buf[IB_WORK_LEFT ];
-        irb = gl->interpolate_buf[IB_WORK_RIGHT];
-        for (t = 0; t < bsz; ++t) {
-            /* Obtain start/end values at this index for left & right buffers */
-            float
-                ilbs = gl->interpolate_buf[IB_START_LEFT ][t],
-                ilbe = gl->interpolate_buf[IB_END_LEFT   ][t],
-                irbs = gl->interpolate_buf[IB_START_RIGHT][t],
-                irbe = gl->interpolate_buf[IB_END_RIGHT  ][t],
-                mod  = uratio * gl->kcounter; /* modifier for this frame */
-            if (mod > 1.0F) mod = 1.0F;
-            ilb[t] = ilbs + ((ilbe - ilbs) * mod);
-            irb[t] = irbs + ((irbe - irbs) * mod);
-        }
-    }
+    /* Audio data only changes on update frames, or while still interpolating towards the
+       last update */
+    bool audio_changed = modified ||
+        (gl->interpolate && (gl->kcounter == 0 || uratio * (gl->kcounter - 1) < 1.0F));
     
     /* Handle external resize requests */
     if (gl->wcb->offscreen()) {
@@ -1818,22 +2970,39 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
     gl->wcb->get_fbsize(gl->w, &ww, &wh);
     gl->wcb->get_pos(gl->w, &wx, &wy);
     
-    /* Resize screen textures if needed */
-    if (ww != gl->lww || wh != gl->lwh) {
+    /* Resize screen textures if needed; stages that are not columns share the textures of
+       their assigned render targets */
+    bool resized = ww != gl->lww || wh != gl->lwh;
+    if (resized) {
         for (t = 0; t < gl->stages_sz; ++t) {
-            if (gl->stages[t].indirect) {
+            if (gl->stages[t].column && gl->stages[t].indirect) {
                 setup_sfbo(&gl->stages[t], ww, wh);
             }
         }
-        if (gl->test_mode || gl->wcb->offscreen())
-            setup_sfbo(&gl->off_sfbo, ww, wh);
+        for (t = 0; t < gl->targets_sz; ++t) {
+            setup_sfbo(&gl->targets[t], ww, wh);
+        }
+        if (gl->test_mode || gl->wcb->offscreen()) {
+            setup_sfbo(&gl->off_sfbo[0], ww, wh);
+            setup_sfbo(&gl->off_sfbo[1], ww, wh);
+        }
+        if (gl->copy_desktop)
+            setup_sfbo(&gl->bg_sfbo, ww, wh);
     }
 
     /* Resize and grab new background data if needed */
-    if (gl->copy_desktop && (gl->wcb->bg_changed(gl->w)
-                             || ww != gl->lww || wh != gl->lwh
-                             || wx != gl->lwx || wy != gl->lwy)) {
-        gl->bg_tex = xwin_copyglbg(r, gl->bg_tex);
+    bool bg_update = gl->copy_desktop && (gl->wcb->bg_changed(gl->w) || resized
+                                          || wx != gl->lwx || wy != gl->lwy);
+    if (bg_update) {
+        /* Sample the root pixmap directly where possible, otherwise copy our section of it */
+        if (!(gl->bg_view = xwin_bindglbg(r, gl->bg_offset, &gl->bg_flip))) {
+            gl->bg_tex       = xwin_copyglbg(r, gl->bg_tex);
+            gl->bg_view      = gl->bg_tex;
+            gl->bg_offset[0] = 0;
+            gl->bg_offset[1] = wh;
+            gl->bg_flip      = -1;
+        }
+        gl->bg_dirty = true;
     }
 
     gl->lwx = wx;
@@ -1841,7 +3010,7 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
     gl->lww = ww;
     gl->lwh = wh;
     
-    glViewport(0, 0, ww, wh);
+    st_reset(&gl->st);
     
     static char     stdin_buf_store[128] = {};
     static char*    stdin_buf            = stdin_buf_store;
@@ -2004,14 +3173,59 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
         }
     }
         
-    struct gl_sfbo* prev = NULL;
+    /* Redraw all stages if their textures were reallocated, the window contents were lost, or
+       if there is a uniform from the pipe to pass */
+    bool redraw = gl->wcb->poll_events(gl->w) || resized || stdin_uniform_ready;
+    bool present = false; /* if the final stage was drawn this frame */
+    
+    /* Update the frame block, only uploading it if its contents changed */
+    memcpy(gl->frame_data,      (GLint[]) { ww, wh }, sizeof(GLint) * 2);
+    memcpy(gl->frame_data + 8,  &(GLfloat) { (GLfloat) gl->time }, sizeof(GLfloat));
+    memcpy(gl->frame_data + 12, &(GLint) { (GLint) bsz }, sizeof(GLint));
+    if (stdin_uniform_ready) {
+        unsigned char* dst = gl->frame_data + (gl->stdin_type != STDIN_TYPE_NONE ?
+                                               gl->stdin_offset : gl->pipe_offsets[stdin_bind_off]);
+        switch (stdin_select) {
+            case STDIN_TYPE_BOOL:
+                memcpy(dst, &(GLint) { (GLint) stdin_parsed.b }, sizeof(GLint));
+                break;
+            case STDIN_TYPE_INT:
+                memcpy(dst, &(GLint) { stdin_parsed.i }, sizeof(GLint));
+                break;
+            case STDIN_TYPE_FLOAT: memcpy(dst, stdin_parsed.f, sizeof(GLfloat) * 1); break;
+            case STDIN_TYPE_VEC2:  memcpy(dst, stdin_parsed.f, sizeof(GLfloat) * 2); break;
+            case STDIN_TYPE_VEC3:  memcpy(dst, stdin_parsed.f, sizeof(GLfloat) * 3); break;
+            case STDIN_TYPE_VEC4:  memcpy(dst, stdin_parsed.f, sizeof(GLfloat) * 4); break;
+            default: break;
+        }
+        stdin_uniform_ready = false;
+    }
+    ST_CALL(gl, memcmp(gl->frame_data, gl->frame_last, gl->frame_sz), {
+            if (GLAD_GL_VERSION_4_5) {
+                glNamedBufferSubData(gl->frame_ubo, 0, gl->frame_sz, gl->frame_data);
+            } else {
+                glBindBuffer(GL_UNIFORM_BUFFER, gl->frame_ubo);
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, gl->frame_sz, gl->frame_data);
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            }
+            memcpy(gl->frame_last, gl->frame_data, gl->frame_sz);
+        });
+    
+    struct gl_sfbo* prev = NULL, * column = NULL;
 
     /* Iterate through each rendering stage (shader) */
     
     for (t = 0; t < gl->stages_sz; ++t) {
 
-        MUTABLE bool  load_flags_s[64] = { [ 0 ... 63 ] = false };
-        MUTABLE bool* load_flags       = load_flags_s; /* Load flags for each texture position */
+        MUTABLE bool    load_flags_s[64] = { [ 0 ... 63 ] = false };
+        MUTABLE bool*   load_flags       = load_flags_s; /* Load flags for each texture position */
+        MUTABLE GLuint  load_texs_s[64];
+        MUTABLE GLuint* load_texs        = load_texs_s;  /* Processed texture for each position */
+        
+        /* Textures to bind once all audio passes for this stage have completed */
+        MUTABLE struct deferred_tex { GLuint unit, tex; GLenum target; } deferred_s[8];
+        MUTABLE struct deferred_tex* deferred = deferred_s;
+        MUTABLE size_t deferred_sz = 0;
         
         /* Current shader program */
         struct gl_sfbo* current = &gl->stages[t];
@@ -2019,86 +3233,79 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
         if (!current->shader || (current->nativeonly && !gl->premultiply_alpha))
             continue;
         
-        /* Bind framebuffer if this is not the final pass */
-        if (current->indirect)
-            glBindFramebuffer(GL_FRAMEBUFFER, current->fbo);
-        else if (gl->test_mode || gl->wcb->offscreen())
-            glBindFramebuffer(GL_FRAMEBUFFER, gl->off_sfbo.fbo);
+        /* Decimated stages keep their last output until their next update is due */
+        if (DECIMATED(current)) {
+            ++current->frames;
+            bool due = current->frames >= current->interval
+                && (current->rate <= 0.0F || gl->clock - current->updated >= 1.0 / current->rate);
+            if (!due && !redraw && current->valid) {
+                current->changed = false;
+                if (current->column)
+                    column = current;
+                else prev = current;
+                continue;
+            }
+        }
+        
+        /* Check if any of the inputs to this stage have changed since it was last drawn */
+        current->changed = redraw || (!current->indirect && bg_update);
+        for (size_t b = 0; b < current->binds_sz && !current->changed; ++b) {
+            switch (current->binds[b].src_type) {
+                case SRC_PREV:         current->changed = prev   && prev->changed;   break;
+                case SRC_COLUMN:       current->changed = column && column->changed; break;
+                case SRC_TIME:         current->changed = true;                      break;
+                case SRC_AUDIO_L:
+                case SRC_AUDIO_R:
+                case SRC_AUDIO_L_PSUM:
+                case SRC_AUDIO_R_PSUM: current->changed = audio_changed;             break;
+            }
+        }
+        
+        /* Unchanged stages are skipped if their output has not been overwritten by another
+           stage sharing the same render target. Stages that are redrawn only to restore their
+           output are not considered changed for the stages that read from them. */
+        if (!current->changed && current->valid) {
+            if (current->column)
+                column = current;
+            else prev = current;
+            continue;
+        }
+        
+        /* Framebuffer for this stage; the final pass renders directly unless offscreen */
+        GLuint fbo = current->indirect ? current->fbo
+            : (gl->test_mode || gl->wcb->offscreen() ? gl->off_sfbo[off_begin(r)].fbo : 0);
+        st_fbo(gl, fbo);
         
-        glClear(GL_COLOR_BUFFER_BIT);
+        /* Viewport for this stage; column passes only render a single row, and indirect stages
+           may render at a fraction of the window size */
+        int scale = current->indirect ? current->scale : 1;
+        int vw = current->column ? COLUMN_LENGTH(ww, wh) : SCALED_SIZE(ww, scale);
+        int vh = current->column ? 1 : SCALED_SIZE(wh, scale);
         
         if (!current->indirect && gl->copy_desktop) {
-            /* Shader to flip texture and override alpha channel.
-               This is embedded since we don't need any GLSL preprocessing here */
-            static const char* frag_shader =
-                "uniform sampler2D tex;"                                                             "\n"
-                "uniform ivec2 screen;"                                                              "\n"
-                "out vec4 fragment;"                                                                 "\n"
-                "in vec4 gl_FragCoord;"                                                              "\n"
-                "void main() {"                                                                      "\n"
-                "    fragment = texelFetch(tex, ivec2(gl_FragCoord.x, "                              "\n"
-                "                       screen.y - gl_FragCoord.y), 0);"                             "\n"
-                "    fragment.a = 1.0F;"                                                             "\n"
-                "}"                                                                                  "\n";
-            if (!gl->bg_setup) {
-                gl->bg_prog = shaderlink(shaderload(NULL, GL_VERTEX_SHADER, VERTEX_SHADER_SRC,
-                                                    NULL, NULL, NULL, 330, true, NULL, gl),
-                                         shaderload(NULL, GL_FRAGMENT_SHADER, frag_shader,
-                                                    NULL, NULL, NULL, 330, true, NULL, gl));
-                gl->bg_utex   = glGetUniformLocation(gl->bg_prog, "tex");
-                gl->bg_screen = glGetUniformLocation(gl->bg_prog, "screen");
-                glBindFragDataLocation(gl->bg_prog, 1, "fragment");
-                gl->bg_setup = true;
+            /* The background only changes when it is updated or the window moves, so it is
+               composited once and copied in. Multisampled windows cannot be blitted to, so
+               the background is drawn for those instead. */
+            if (gl->bg_blit < 0) {
+                GLint samples;
+                glGetIntegerv(GL_SAMPLE_BUFFERS, &samples);
+                gl->bg_blit = samples == 0;
             }
-            glUseProgram(gl->bg_prog);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gl->bg_tex);
-            glUniform2i(gl->bg_screen, (GLint) ww, (GLint) wh);
-            glUniform1i(gl->bg_utex, 0);
-            /* We need to disable blending, we might read in bogus alpha values due
-               to how we obtain the background texture (format is four byte `rgb_`, 
-               where the last value is skipped) */
-            if (!gl->premultiply_alpha) glDisable(GL_BLEND);
-            drawoverlay(&gl->overlay);
-            if (!gl->premultiply_alpha) glEnable(GL_BLEND);
-            glUseProgram(0);
-        }
+            if (gl->bg_blit) {
+                if (gl->bg_dirty) {
+                    st_fbo(gl, gl->bg_sfbo.fbo);
+                    drawbackground(gl, ww, wh);
+                    st_fbo(gl, fbo);
+                    gl->bg_dirty = false;
+                }
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, gl->bg_sfbo.fbo);
+                glBlitFramebuffer(0, 0, ww, wh, 0, 0, ww, wh, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            } else drawbackground(gl, ww, wh);
+        } else glClear(GL_COLOR_BUFFER_BIT);
         
         /* Select the program associated with this pass */
-        glUseProgram(current->shader);
-
-        /* Pass uniform if one has been parsed */
-        if (stdin_uniform_ready) {
-            GLuint handle = gl->stdin_type != STDIN_TYPE_NONE ? current->stdin_uniform :
-                current->pipe_uniforms[stdin_bind_off];
-            switch (stdin_select) {
-                case STDIN_TYPE_BOOL:
-                    glUniform1i(handle, (int) stdin_parsed.b);
-                    break;
-                case STDIN_TYPE_INT:
-                    glUniform1i(handle, stdin_parsed.i);
-                    break;
-                case STDIN_TYPE_FLOAT:
-                    glUniform1f(handle, stdin_parsed.f[0]);
-                    break;
-                case STDIN_TYPE_VEC2:
-                    glUniform2f(handle,
-                                stdin_parsed.f[0], stdin_parsed.f[1]);
-                    break;
-                case STDIN_TYPE_VEC3:
-                    glUniform3f(handle,
-                                stdin_parsed.f[0], stdin_parsed.f[1],
-                                stdin_parsed.f[2]);
-                    break;
-                case STDIN_TYPE_VEC4:
-                    glUniform4f(handle,
-                                stdin_parsed.f[0], stdin_parsed.f[1],
-                                stdin_parsed.f[2], stdin_parsed.f[3]);
-                    break;
-                default: break;
-            }
-            stdin_uniform_ready = false;
-        }
+        st_program(gl, current->shader);
         
         bool prev_bound = false;
         
@@ -2110,11 +3317,22 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
             struct gl_bind* bind = &current->binds[b];
             
             /* Handle transformations and bindings for 1D samplers */
-            INLINE(void, handle_audio)(GLuint tex, float* buf, float* ubuf,
-                                        size_t sz, int offset, bool audio) {
-                if (load_flags[offset])
+            INLINE(void, handle_audio)(GLuint tex, float* buf, size_t sz,
+                                        int offset, bool audio, bool psum) {
+                if (load_flags[offset]) {
+                    tex = load_texs[offset];
                     goto bind_uniform;
+                }
                 load_flags[offset] = true;
+                
+                /* Between updates, blend the last two keyframes instead of processing the
+                   (unchanged) audio buffer again */
+                bool interpolate = audio && gl->interpolate;
+                if (interpolate && !modified && bind->keyed && bind->key[bind->key_idx].sz == sz) {
+                    float factor = uratio * gl->kcounter;
+                    tex = mix_keyframes(gl, bind, offset, sz, factor > 1.0F ? 1.0F : factor);
+                    goto load_texture;
+                }
                     
                 bool set_opt = false; /* if bind->optimize_fft was set this frame */
                 
@@ -2159,13 +3377,6 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                                 transform types are added) */
                     }
                     if (set_opt) {
-                        /* Force CPU interpolation off if we are pushing fft to the GPU,
-                           as it requires the buffer data on system memory is updated with
-                           transformation data (and is quite slow) */
-                        if (old_interpolate)
-                            gl->interpolate_glsl = true;
-                        old_interpolate = false;
-                        gl->interpolate = false;
                         /* Minor microptimization: truncate transforms if we're optimizing
                            the tailing FFT transform type, since we don't actually apply
                            them at this point. */
@@ -2179,10 +3390,8 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                                   &((struct gl_sampler_data) { .buf = buf, .sz = sz } ));
                 }
                 
-                glActiveTexture(GL_TEXTURE0 + offset);
-                
                 /* Update texture with our data */
-                update_1d_tex(tex, sz, gl->interpolate ? (ubuf ? ubuf : buf) : buf);
+                update_1d_tex(gl, offset, tex, sz, buf);
                 
                 /* Apply audio-specific transformations in GLSL, if enabled */
                 if (bind->optimize_fft) {
@@ -2194,20 +3403,17 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                             gr->out    = calloc(gl->avg_frames, sizeof(struct sm_fb));
                             gr->out_sz = gl->avg_frames;
                         }
-                        bind_1d_fbo(gr_store, sz);
+                        bind_1d_fbo(gl, gr_store, sz, GL_R16);
                         
                         /* Do the gravity storage computation with GL_MAX */
-                        glUseProgram(gl->p_prog);
-                        glActiveTexture(GL_TEXTURE0 + offset);
-                        glBindTexture(GL_TEXTURE_1D, tex);
-                        glUniform1i(gl->p_utex, offset);
-                        if (gl->premultiply_alpha) glEnable(GL_BLEND);
-                        glBlendEquation(GL_MAX);
-                        glViewport(0, 0, sz, 1);
-                        drawoverlay(&gl->overlay);
-                        glViewport(0, 0, ww, wh);
-                        glBlendEquation(GL_FUNC_ADD);
-                        if (gl->premultiply_alpha) glDisable(GL_BLEND);
+                        st_program(gl, gl->p_prog);
+                        st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                        st_uniform1i(gl, gl->p_prog, gl->p_utex, offset);
+                        st_blend(gl, true);
+                        st_blend_eq(gl, GL_MAX);
+                        st_viewport(gl, sz, 1);
+                        drawoverlay(gl);
+                        st_blend_eq(gl, GL_FUNC_ADD);
                         tex = gr_store->tex;
                         
                         /* We are using this barrier extension so we can apply
@@ -2217,53 +3423,43 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                         glTextureBarrierNV();
                         
                         /* Apply gravity */
-                        glUseProgram(gl->gr_prog);
-                        glActiveTexture(GL_TEXTURE0 + offset);
-                        glBindTexture(GL_TEXTURE_1D, tex);
-                        glUniform1i(gl->gr_utex, offset);
-                        glUniform1f(gl->gr_udiff, gl->gravity_step * (1.0F / gl->ur));
-                        if (!gl->premultiply_alpha) glDisable(GL_BLEND);
-                        glViewport(0, 0, sz, 1);
-                        drawoverlay(&gl->overlay);
-                        glViewport(0, 0, ww, wh);
+                        st_program(gl, gl->gr_prog);
+                        st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                        st_uniform1i(gl, gl->gr_prog, gl->gr_utex, offset);
+                        st_uniform1f(gl, gl->gr_prog, gl->gr_udiff, gl->gravity_step * (1.0F / gl->ur));
+                        st_blend(gl, false);
+                        drawoverlay(gl);
                         
                         if (gl->avg_frames > 1) {
                             
                             /* Write gravity buffer to output frames as if they are a
                                circular buffer. This prevents needless texture shifts */
                             struct sm_fb* out_frame = &gr->out[gr->out_idx];
-                            bind_1d_fbo(out_frame, sz);
-                            glUseProgram(gl->p_prog);
-                            glActiveTexture(GL_TEXTURE0 + offset);
-                            glBindTexture(GL_TEXTURE_1D, tex);
-                            glUniform1i(gl->p_utex, offset);
-                            glViewport(0, 0, sz, 1);
-                            drawoverlay(&gl->overlay);
-                            glViewport(0, 0, ww, wh);
+                            bind_1d_fbo(gl, out_frame, sz, GL_R16);
+                            st_program(gl, gl->p_prog);
+                            st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                            st_uniform1i(gl, gl->p_prog, gl->p_utex, offset);
+                            drawoverlay(gl);
                             
                             /* Read circular buffer into averaging shader */
-                            bind_1d_fbo(av, sz);
-                            glUseProgram(gl->av_prog);
+                            bind_1d_fbo(gl, av, sz, GL_R16);
+                            st_program(gl, gl->av_prog);
                             for (int t = 0; t < (int) gr->out_sz; ++t) {
                                 GLuint c_off = offset + 1 + t;
-                                glActiveTexture(GL_TEXTURE0 + c_off);
                                 /* Textures are bound in descending order, such that
                                    t0 is the most recent, and t[max - 1] is the last. */
                                 int fr = gr->out_idx - t;
                                 if (fr < 0)
                                     fr = gr->out_sz + fr;
-                                glBindTexture(GL_TEXTURE_1D, gr->out[fr].tex);
-                                glUniform1i(gl->av_utex[t], c_off);
+                                st_texture(gl, c_off, GL_TEXTURE_1D, gr->out[fr].tex);
+                                st_uniform1i(gl, gl->av_prog, gl->av_utex[t], c_off);
                             }
-                            glViewport(0, 0, sz, 1);
-                            drawoverlay(&gl->overlay);
-                            glViewport(0, 0, ww, wh);
+                            drawoverlay(gl);
                             ++gr->out_idx;
                             if (gr->out_idx >= gr->out_sz)
                                 gr->out_idx = 0;
                             tex = av->tex;
                         }
-                        if (!gl->premultiply_alpha) glEnable(GL_BLEND);
                         
                     } else {
                         /* No audio buffer update; use last average result */
@@ -2277,35 +3473,55 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                     
                     /* Allocate and setup our per-bind data, if needed */
                     struct sm_fb* sm = &bind->sm;
-                    bind_1d_fbo(sm, sz);
-                    
-                    glUseProgram(gl->sm_prog);
-                    glActiveTexture(GL_TEXTURE0 + offset);
-                    glBindTexture(GL_TEXTURE_1D, tex);
-                    glUniform1i(gl->sm_uw, sz);  /* target texture width */
-                    glUniform1i(gl->sm_usz, sz); /* source texture width */
-                    glUniform1i(gl->sm_utex, offset);
-                    if (!gl->premultiply_alpha) glDisable(GL_BLEND);
-                    glViewport(0, 0, sz, 1);
-                    drawoverlay(&gl->overlay);
-                    glViewport(0, 0, ww, wh);
-                    if (!gl->premultiply_alpha) glEnable(GL_BLEND);
+                    bind_1d_fbo(gl, sm, sz, GL_R16);
                     
-                    /* Return state */
-                    glUseProgram(current->shader);
-                    if (current->indirect)
-                        glBindFramebuffer(GL_FRAMEBUFFER, current->fbo);
-                    else if (gl->test_mode || gl->wcb->offscreen())
-                        glBindFramebuffer(GL_FRAMEBUFFER, gl->off_sfbo.fbo);
-                    else glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                    st_program(gl, gl->sm_prog);
+                    st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                    st_uniform1i(gl, gl->sm_prog, gl->sm_uw, sz);  /* target texture width */
+                    st_uniform1i(gl, gl->sm_prog, gl->sm_usz, sz); /* source texture width */
+                    st_uniform1i(gl, gl->sm_prog, gl->sm_utex, offset);
+                    st_blend(gl, false);
+                    st_viewport(gl, sz, 1);
+                    drawoverlay(gl);
 
                     tex = sm->tex; /* replace input texture with our processed one */
                 }
                 
-                glActiveTexture(GL_TEXTURE0 + offset);
-                glBindTexture(GL_TEXTURE_1D, tex);
+                /* Keep the processed result as a keyframe; what is displayed lags one update
+                   behind, starting from the previous keyframe */
+                if (interpolate && modified) {
+                    push_keyframe(gl, bind, tex, offset, sz);
+                    tex = mix_keyframes(gl, bind, offset, sz, 0.0F);
+                }
+                
+            load_texture:
+                st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                load_texs[offset] = tex;
             bind_uniform:
-                glUniform1i(bind->uniform, offset);
+                if (psum) {
+                    /* Inclusive prefix sum of the processed texture (Hillis-Steele scan), stored
+                       as floats so ranges can be averaged with two fetches. Each pass adds the
+                       value `step` texels behind, doubling `step` until it covers the buffer. */
+                    GLuint src = tex;
+                    st_program(gl, gl->ps_prog);
+                    st_uniform1i(gl, gl->ps_prog, gl->ps_utex, offset);
+                    st_blend(gl, false);
+                    st_viewport(gl, sz, 1);
+                    for (size_t step = 1, p = 0; step < sz; step <<= 1, p ^= 1) {
+                        bind_1d_fbo(gl, &bind->ps[p], sz, GL_R32F);
+                        st_texture(gl, offset, GL_TEXTURE_1D, src);
+                        st_uniform1i(gl, gl->ps_prog, gl->ps_ustep, (GLint) step);
+                        drawoverlay(gl);
+                        src = bind->ps[p].tex;
+                    }
+                    
+                    /* The unscanned texture is still bound for other uses of this offset */
+                    st_texture(gl, offset, GL_TEXTURE_1D, tex);
+                    deferred[deferred_sz++] = (struct deferred_tex) {
+                        .unit = PSUM_TEXTURE_UNIT(offset), .tex = src, .target = GL_TEXTURE_1D
+                    };
+                    st_bind_uniform(gl, current->shader, bind, PSUM_TEXTURE_UNIT(offset), 0);
+                } else st_bind_uniform(gl, current->shader, bind, offset, 0);
             }; /* <-- this pesky semicolon is only required in clang because of how blocks work */
 
             /* Handle each binding source; only bother to handle transformations
@@ -2316,50 +3532,114 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                     /* bind texture and pass it to the shader uniform if we need to pass
                        the sampler from the previous pass */
                     if (!prev_bound && prev != NULL) {
-                        glActiveTexture(GL_TEXTURE0);
-                        glBindTexture(GL_TEXTURE_2D, prev->tex);
+                        st_texture(gl, 0, GL_TEXTURE_2D, prev->tex);
                         prev_bound = true;
                     }
-                    glUniform1i(bind->uniform, 0);
+                    st_bind_uniform(gl, current->shader, bind, 0, 0);
+                    break;
+                case SRC_COLUMN:
+                    if (column != NULL) {
+                        deferred[deferred_sz++] = (struct deferred_tex) {
+                            .unit = COLUMN_TEXTURE_UNIT, .tex = column->tex, .target = GL_TEXTURE_2D
+                        };
+                    }
+                    st_bind_uniform(gl, current->shader, bind, COLUMN_TEXTURE_UNIT, 0);
+                    break;
+                case SRC_AUDIO_L:      handle_audio(gl->audio_tex_l, lb, bsz, 1, true, false); break;
+                case SRC_AUDIO_R:      handle_audio(gl->audio_tex_r, rb, bsz, 2, true, false); break;
+                case SRC_AUDIO_L_PSUM: handle_audio(gl->audio_tex_l, lb, bsz, 1, true, true);  break;
+                case SRC_AUDIO_R_PSUM: handle_audio(gl->audio_tex_r, rb, bsz, 2, true, true);  break;
+                /* per-frame globals only need to be set here if the uniform was not mapped to
+                   the frame block, see `map_frame_uniforms` */
+                case SRC_AUDIO_SZ:
+                    if ((GLint) bind->uniform == -1) break;
+                    st_bind_uniform(gl, current->shader, bind, (GLint) bsz, 0);
+                    break;
+                case SRC_SCREEN:
+                    if ((GLint) bind->uniform == -1) break;
+                    /* reduced size stages see the dimensions of their own render target */
+                    if (current->column) st_bind_uniform(gl, current->shader, bind, ww, wh);
+                    else                 st_bind_uniform(gl, current->shader, bind, vw, vh);
+                    break;
+                case SRC_TIME:
+                    if ((GLint) bind->uniform == -1) break;
+                    st_uniform1f(gl, current->shader, bind->uniform, (GLfloat) gl->time);
                     break;
-                case SRC_AUDIO_L:  handle_audio(gl->audio_tex_l, lb, ilb, bsz, 1, true); break;
-                case SRC_AUDIO_R:  handle_audio(gl->audio_tex_r, rb, irb, bsz, 2, true); break;
-                case SRC_AUDIO_SZ: glUniform1i(bind->uniform, bsz);                       break;
-                case SRC_SCREEN:   glUniform2i(bind->uniform, (GLint) ww, (GLint) wh);    break;
-                case SRC_TIME:     glUniform1f(bind->uniform, (GLfloat) gl->time);        break;
             }
         }
         
-        drawoverlay(&gl->overlay); /* Fullscreen quad (actually just two triangles) */
-
-        /* Reset some state */
+        for (size_t d = 0; d < deferred_sz; ++d)
+            st_texture(gl, deferred[d].unit, deferred[d].target, deferred[d].tex);
+        
+        /* Restore state for this stage, which may have been changed by audio passes. Column
+           values are stored as-is, without blending against the cleared buffer. */
+        st_fbo(gl, fbo);
+        st_program(gl, current->shader);
+        st_viewport(gl, vw, vh);
+        st_blend(gl, !gl->premultiply_alpha && !current->column);
+        
+        if (current->instanced) {
+            /* Module geometry; by default, one instance per pixel along the longer axis */
+            drawinstanced(gl, current->instances > 0
+                          ? current->instances : COLUMN_LENGTH(ww, wh));
+        } else drawoverlay(gl); /* Fullscreen quad (actually just two triangles) */
+        
+        /* Invalidate the output of other stages rendering to the same target */
         if (current->indirect) {
-            if (gl->test_mode || gl->wcb->offscreen())
-                glBindFramebuffer(GL_FRAMEBUFFER, gl->off_sfbo.fbo);
-            else
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        }
-        glUseProgram(0);
-
-        prev = current;
+            for (size_t u = 0; u < gl->stages_sz; ++u) {
+                if (gl->stages[u].indirect && gl->stages[u].fbo == current->fbo)
+                    gl->stages[u].valid = false;
+            }
+        } else present = true;
+        current->valid   = true;
+        current->frames  = 0;
+        current->updated = gl->clock;
+
+        /* Column passes are not treated as `prev` for the following stage */
+        if (current->column)
+            column = current;
+        else prev = current;
     }
-
-    /* Push and copy buffer if we need to interpolate from it later */
-    if (gl->interpolate && modified) {
-        memcpy(gl->interpolate_buf[IB_START_LEFT ], gl->interpolate_buf[IB_END_LEFT ], fbsz);
-        memcpy(gl->interpolate_buf[IB_START_RIGHT], gl->interpolate_buf[IB_END_RIGHT], fbsz);
-        memcpy(gl->interpolate_buf[IB_END_LEFT   ], lb, fbsz);
-        memcpy(gl->interpolate_buf[IB_END_RIGHT  ], rb, fbsz);
+    
+    /* Leave the final framebuffer bound, so offscreen results can be read back */
+    st_fbo(gl, gl->test_mode || gl->wcb->offscreen() ? gl->off_sfbo[gl->off_cur].fbo : 0);
+    st_viewport(gl, ww, wh);
+
+    if (__atomic_load_n(&r->readback.enabled, __ATOMIC_SEQ_CST)) {
+        readback_collect(r, READBACK_RING);
+        /* Offline output needs every frame, even if it is unchanged */
+        if (present || r->offline)
+            readback_frame(r, ww, wh);
+    } else if (gl->rb.slots[0].pbo)
+        readback_free(&gl->rb);
+
+    /* Swap buffers, handle events, etc. (vsync is potentially included here, too). If nothing
+       was drawn, the last frame is still being displayed and we can skip presenting. */
+    if (present) {
+        gl->wcb->swap_buffers(gl->w);
+        if (gl->test_mode || gl->wcb->offscreen())
+            off_publish(r);
     }
 
-    /* Swap buffers, handle events, etc. (vsync is potentially included here, too) */
-    gl->wcb->swap_buffers(gl->w);
-
     double duration = gl->wcb->get_time(gl->w); /* frame execution time */
+    if (present) {
+        gl->ptime = duration;
+        gl->gov.work += duration;
+        ++gl->gov.frames;
+    }
 
-    /* Handling sleeping (to meet target framerate) */
-    if (gl->rate > 0) {
-        double target = 1.0 / (double) gl->rate; /* 1 / freq = time per frame */
+    /* Handling sleeping (to meet target framerate). Skipped frames are not limited by vsync, so
+       wait as long as the last presented frame took instead. Offline rendering advances by
+       exactly one frame, as fast as frames can be drawn. Renderers stepped by the host never
+       sleep, and advance by the time that passed since the last step. */
+    if (r->offline)
+        duration = 1.0 / (double) rd_get_offline_rate(r);
+    else if (r->host) {
+        if (r->step > duration)
+            duration = r->step;
+    } else if (gl->rate > 0 || !present) {
+        double target = gl->rate > 0 ? 1.0 / (double) gl->rate /* 1 / freq = time per frame */
+            : gl->ptime;
         if (duration < target) {
             double sleep = target - duration;
             struct timespec tv = {
@@ -2373,6 +3653,7 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
 
     /* Handle counters and print FPS counter (if needed) */
 
+    gl->clock += duration;    /* running time, for decimated stages               */
     ++gl->time;               /* shader uniform time value */
     if (gl->time >= gl->timecycle)
         gl->time -= gl->timecycle;
@@ -2394,6 +3675,22 @@ bool rd_update(struct glava_renderer* r, float* lb, float* rb, size_t bsz, bool
                    (double) gl->fr, (double) gl->ur);
             #endif
         }
+        if (gl->verbose) {
+            printf("GL calls per frame: %.1f, redundant calls skipped: %.1f\n",
+                   (double) gl->st.calls / gl->fcounter, (double) gl->st.skipped / gl->fcounter);
+        }
+        /* Offline output is not real time, and should not trade quality for speed */
+        if (gl->gov.budget > 0.0F && !r->offline)
+            gov_update(gl, old_interpolate);
+        if ((gl->policy.states[POLICY_BATTERY].set || gl->policy.states[POLICY_LOAD].set)
+            && gl->clock - gl->policy.checked >= POLICY_INTERVAL && !r->offline) {
+            policy_update(gl);
+            gl->policy.checked = gl->clock;
+        }
+        gl->gov.work   = 0.0;
+        gl->gov.frames = 0;
+        gl->st.calls   = 0;
+        gl->st.skipped = 0;
         gl->tcounter = 0;                     /* reset timer          */
         gl->fcounter = 0;                     /* reset frame counter  */
         gl->ucounter = 0;                     /* reset update counter */
@@ -2453,12 +3750,62 @@ end_test:
 }
 #endif
 
+/* Frame rate for offline rendering, which cannot be unlimited */
+int rd_get_offline_rate(struct glava_renderer* r) {
+    return r->gl->rate > 0 ? r->gl->rate : OFFLINE_RATE;
+}
+
+/* Acquire the latest complete offscreen frame on the calling thread's context, which must
+   share objects with the renderer. The GPU is made to wait for the frame to finish drawing;
+   the calling thread is not blocked. Returns 0 if there is no offscreen output. */
+unsigned int rd_acquire(struct glava_renderer* r, uint64_t* seq) {
+    if (!__atomic_load_n(&r->flag, __ATOMIC_SEQ_CST))
+        return 0;
+    pthread_mutex_lock(&r->lock);
+    int f = r->out.front;
+    if (r->out.ready[f])
+        glWaitSync(r->out.ready[f], 0, GL_TIMEOUT_IGNORED);
+    r->out.held = f;
+    if (seq) *seq = r->out.seq;
+    unsigned int tex = r->gl->off_sfbo[f].tex;
+    pthread_mutex_unlock(&r->lock);
+    return tex;
+}
+
+/* Release the frame from `rd_acquire` once all commands sampling it have been issued */
+void rd_release(struct glava_renderer* r) {
+    if (!__atomic_load_n(&r->flag, __ATOMIC_SEQ_CST))
+        return;
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    pthread_mutex_lock(&r->lock);
+    int h = r->out.held;
+    if (h >= 0) {
+        if (r->out.done[h])
+            glDeleteSync(r->out.done[h]);
+        r->out.done[h] = fence;
+        r->out.held = -1;
+        pthread_cond_broadcast(&r->cond);
+    } else glDeleteSync(fence);
+    pthread_mutex_unlock(&r->lock);
+}
+
 void*          rd_get_impl_window (struct glava_renderer* r)  { return r->gl->w;   }
 struct gl_wcb* rd_get_wcb         (struct glava_renderer* r)  { return r->gl->wcb; }
 
 void rd_destroy(struct glava_renderer* r) {
+    if (r->gl->copy_desktop)
+        xwin_freeglbg();
+    if (r->readback.lossless && __atomic_load_n(&r->readback.enabled, __ATOMIC_SEQ_CST))
+        readback_collect(r, 0); /* deliver the remaining frames */
+    readback_free(&r->gl->rb);
+    for (int t = 0; t < 2; ++t) {
+        if (r->out.ready[t]) glDeleteSync(r->out.ready[t]);
+        if (r->out.done[t])  glDeleteSync(r->out.done[t]);
+    }
     r->gl->wcb->destroy(r->gl->w);
-    if (r->gl->interpolate_buf[0]) free(r->gl->interpolate_buf[0]);
+    if (r->gl->check_fullscreen)
+        xwin_close_fullscreen_check();
     size_t t, b;
     if (r->gl->t_data) {
         for (t = 0; t < r->gl->t_count; ++t) {
@@ -2477,14 +3824,26 @@ void rd_destroy(struct glava_renderer* r) {
             free((char*) bind->name); /* strdup */
         }
         free(stage->binds);
+        if (stage->epilogue)
+            free(stage->epilogue);
         free((char*) stage->name); /* strdup */
     }
     if (r->gl->av_utex)
         free(r->gl->av_utex);
     free(r->gl->stages);
+    free(r->gl->targets);
+    free(r->gl->frame_header);
+    free(r->gl->frame_data);
+    free(r->gl->frame_last);
+    free(r->gl->pipe_offsets);
+    free(r->gl->frame_binds);
+    free(r->gl->policy.path);
+    decimator_free(&r->gl->dec);
     r->gl->wcb->terminate();
     free(r->gl);
     if (r->audio_source_request)
         free(r->audio_source_request);
+    if (r->readback.data)
+        free(r->readback.data);
     free(r);
 }
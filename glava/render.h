@@ -10,17 +10,38 @@
 typedef struct glava_renderer {
     volatile bool alive;
     bool    mirror_input;
+    bool    offline; /* advance time by fixed frame steps without sleeping, see `--output` */
+    double  step;    /* time since the last frame stepped by the host, see `glava_step` */
     size_t  bufsize_request, rate_request, samplesize_request;
     char*   audio_source_request;
-    unsigned int    off_tex; /* final GL texture for offscreen rendering */
+    unsigned int    off_tex; /* latest complete GL texture for offscreen rendering */
     pthread_mutex_t lock; /* lock for reading from offscreen texture  */
     pthread_cond_t  cond; /* cond for reading from offscreen texture  */
     bool            flag; /* vadility flag for reading from offscreen tecture */
+    struct {
+        int      front;    /* buffer holding the latest complete frame */
+        int      held;     /* buffer acquired by `glava_acquire`, or -1 */
+        void*    ready[2]; /* GLsync signalled when a buffer has been drawn */
+        void*    done[2];  /* GLsync signalled when the consumer has finished sampling a buffer */
+        uint64_t seq;      /* number of frames published */
+    } out;
     volatile struct {
         int x, y, w, h;
     } sizereq;
     volatile int sizereq_flag;
-    struct gl_data* gl;
+    struct {
+        volatile bool   enabled; /* assigned by `glava_readback` */
+        bool            lossless; /* wait for buffers instead of dropping frames */
+        glava_frame_cb  cb;      /* called from the render thread, or NULL to poll */
+        void*           user;
+        pthread_mutex_t lock;    /* lock for the callback and the latest frame */
+        unsigned char*  data;    /* latest frame, if polling with `glava_frame` */
+        size_t          sz;
+        int             w, h;
+        uint64_t        seq;
+    } readback;
+    struct gl_data*    gl;
+    struct glava_host* host; /* state for renderers from `glava_create`, NULL otherwise */
 } glava_renderer;
 
 extern const struct {
@@ -56,9 +77,12 @@ struct glava_renderer* rd_new            (const char**    paths,        const ch
                                     bool            auto_desktop, bool        verbose,
                                     bool            test_mode);
 bool             rd_update         (struct glava_renderer*, float* lb, float* rb,
-                                    size_t bsz, bool modified);
+                                    size_t bsz, bool modified, size_t fresh);
 void             rd_destroy        (struct glava_renderer*);
 void             rd_time           (struct glava_renderer*);
+int              rd_get_offline_rate(struct glava_renderer*);
+unsigned int     rd_acquire        (struct glava_renderer*, uint64_t* seq);
+void             rd_release        (struct glava_renderer*);
 void*            rd_get_impl_window(struct glava_renderer*);
 struct gl_wcb*   rd_get_wcb        (struct glava_renderer*);
 
@@ -78,6 +102,7 @@ struct gl_wcb {
     bool     (*should_render)  (void* ptr);
     bool     (*bg_changed)     (void* ptr);
     void     (*swap_buffers)   (void* ptr);
+    bool     (*poll_events)    (void* ptr); /* returns true if the window needs to be redrawn */
     void     (*raise)          (void* ptr);
     void     (*destroy)        (void* ptr);
     void     (*terminate)      (void);
@@ -94,6 +119,8 @@ struct gl_wcb {
     void     (*set_time)       (void* ptr, double time);
     void     (*set_visible)    (void* ptr, bool visible);
     const char* (*get_environment) (void);
+    /* binds an X pixmap to a GL texture, returning 0 if this is not supported */
+    unsigned int (*bind_pixmap)    (void* ptr, unsigned long pixmap, int* w, int* h, bool* inverted);
     #ifdef GLAVA_RDX11
     Display* (*get_x11_display)(void);
     Window   (*get_x11_window) (void* ptr);
@@ -116,6 +143,7 @@ struct gl_wcb {
         WCB_FUNC(should_render),                \
         WCB_FUNC(bg_changed),                   \
         WCB_FUNC(swap_buffers),                 \
+        WCB_FUNC(poll_events),                  \
         WCB_FUNC(raise),                        \
         WCB_FUNC(destroy),                      \
         WCB_FUNC(terminate),                    \
@@ -132,8 +160,19 @@ struct gl_wcb {
         WCB_FUNC(get_time),                     \
         WCB_FUNC(set_visible),                  \
         WCB_FUNC(get_environment),              \
-        WCB_FUNC(get_x11_display),              \
-        WCB_FUNC(get_x11_window)                \
+        WCB_FUNC(bind_pixmap),                  \
+        WCB_X11_FUNCS                           \
     }
 
+/* Backends without an X11 connection (ie. EGL) leave these unassigned */
+#ifdef GLAVA_RDX11
+#define WCB_X11_FUNCS                           \
+    WCB_FUNC(get_x11_display),                  \
+    WCB_FUNC(get_x11_window)
+#else
+#define WCB_X11_FUNCS                           \
+    ._X11_DISPLAY_PLACEHOLDER = NULL,           \
+    ._X11_WINDOW_PLACEHOLDER  = NULL
+#endif
+
 #endif /* RENDER_H */
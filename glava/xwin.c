@@ -45,6 +45,8 @@ struct __attribute__((packed)) bmp_header {
 #define BMP_BITFIELDS 3
 
 void xwin_assign_icon_bmp(struct gl_wcb* wcb, void* impl, const char* path) {
+    if (!wcb->get_x11_display)
+        return; /* no window to assign an icon to */
     int fd = open(path, O_RDONLY);
     if (fd == -1) {
         fprintf(stderr, "failed to load icon '%s': %s\n", path, strerror(errno));
@@ -154,6 +156,8 @@ Window* __attribute__ ((unused)) xwin_get_desktop_layer(struct gl_wcb* wcb) {
 
 void xwin_wait_for_wm(void) {
     Display* d = XOpenDisplay(0);
+    if (!d)
+        return; /* no X server, ie. headless rendering */
 
     Atom check = None;
     bool exists = false;
@@ -217,58 +221,106 @@ const char* xwin_detect_wm(struct gl_wcb* wcb) {
     
 }
 
-static int stub_handler(Display* d, XErrorEvent* e) { return 0; }
+/* Fullscreen detection state. A dedicated connection is used so `PropertyNotify` events for the
+   root and active windows can be received regardless of which backend owns the event queue. */
+static struct {
+    Display* d;
+    Atom active_prop, state_prop, fullscreen;
+    Window active;
+    bool fullscreen_active;
+    int (*error_handler)(Display*, XErrorEvent*);
+} fs;
 
-bool xwin_should_render(struct gl_wcb* wcb, void* impl) {
-    bool ret = true, should_close = false;
-    Display* d = wcb->get_x11_display();
-    if (!d) {
-        d = XOpenDisplay(0);
-        should_close = true;
-    }
-    
-    Atom prop       = XInternAtom(d, "_NET_ACTIVE_WINDOW", true);
-    Atom fullscreen = XInternAtom(d, "_NET_WM_STATE_FULLSCREEN", true);
-    
+/* The active window may be destroyed at any time, so errors on our connection are ignored */
+static int fs_error_handler(Display* d, XErrorEvent* e) {
+    if (d == fs.d)
+        return 0;
+    return fs.error_handler ? fs.error_handler(d, e) : 0;
+}
+
+static void fs_read_state(void) {
     Atom actual_type;
-    int actual_format, t;
+    int actual_format;
     unsigned long nitems, bytes_after;
     unsigned char* data = NULL;
     
-    XSetErrorHandler(stub_handler); /* dummy error handler */
-          
-    if (Success != XGetWindowProperty(d, DefaultRootWindow(d), prop, 0, 1, false, AnyPropertyType,
-                                      &actual_type, &actual_format, &nitems, &bytes_after, &data)) {
-        goto close; /* if an error occurs here, the WM probably isn't EWMH compliant */
+    fs.fullscreen_active = false;
+    /* some WMs are a little slow on creating _NET_WM_STATE, so errors may occur here */
+    if (Success == XGetWindowProperty(fs.d, fs.active, fs.state_prop, 0, LONG_MAX, false,
+                                      AnyPropertyType, &actual_type, &actual_format,
+                                      &nitems, &bytes_after, &data) && data) {
+        for (unsigned long t = 0; t < nitems; ++t) {
+            if (fs.fullscreen == ((Atom*) data)[t])
+                fs.fullscreen_active = true;
+        }
     }
-    
-    if (!nitems)
-        goto close;
-    
-    Window active = ((Window*) data)[0];
-
-    prop = XInternAtom(d, "_NET_WM_STATE", true);
+    if (data)
+        XFree(data);
+}
 
-    if (data) {
+static void fs_read_active(void) {
+    Atom actual_type;
+    int actual_format;
+    unsigned long nitems, bytes_after;
+    unsigned char* data = NULL;
+    Window active = None;
+    
+    /* if an error occurs here, the WM probably isn't EWMH compliant */
+    if (Success == XGetWindowProperty(fs.d, DefaultRootWindow(fs.d), fs.active_prop, 0, 1, false,
+                                      AnyPropertyType, &actual_type, &actual_format,
+                                      &nitems, &bytes_after, &data) && data && nitems)
+        active = ((Window*) data)[0];
+    if (data)
         XFree(data);
-        data = NULL;
+    
+    if (active == fs.active)
+        return;
+    
+    /* Follow state changes of the new active window, and read its current state */
+    if (fs.active != None)
+        XSelectInput(fs.d, fs.active, NoEventMask);
+    fs.active            = active;
+    fs.fullscreen_active = false;
+    if (active != None) {
+        XSelectInput(fs.d, active, PropertyChangeMask);
+        fs_read_state();
     }
+}
 
-    if (Success != XGetWindowProperty(d, active, prop, 0, LONG_MAX, false, AnyPropertyType,
-                                      &actual_type, &actual_format, &nitems, &bytes_after, &data)) {
-        goto close; /* some WMs are a little slow on creating _NET_WM_STATE, so errors may occur here */
+bool xwin_should_render(struct gl_wcb* wcb, void* impl) {
+    if (!fs.d) {
+        if (!(fs.d = XOpenDisplay(0)))
+            return true;
+        fs.error_handler = XSetErrorHandler(fs_error_handler);
+        fs.active_prop   = XInternAtom(fs.d, "_NET_ACTIVE_WINDOW",       false);
+        fs.state_prop    = XInternAtom(fs.d, "_NET_WM_STATE",            false);
+        fs.fullscreen    = XInternAtom(fs.d, "_NET_WM_STATE_FULLSCREEN", false);
+        fs.active        = None;
+        XSelectInput(fs.d, DefaultRootWindow(fs.d), PropertyChangeMask);
+        fs_read_active();
     }
-    for (t = 0; t < nitems; ++t) {
-        if (fullscreen == ((Atom*) data)[t]) {
-            ret = false;
-        }
+    
+    /* Only events that have already arrived are handled, this does not wait on the server */
+    while (XPending(fs.d) > 0) {
+        XEvent ev;
+        XNextEvent(fs.d, &ev);
+        if (ev.type != PropertyNotify)
+            continue;
+        if (ev.xproperty.window == DefaultRootWindow(fs.d) && ev.xproperty.atom == fs.active_prop)
+            fs_read_active();
+        else if (ev.xproperty.window == fs.active && ev.xproperty.atom == fs.state_prop)
+            fs_read_state();
+    }
+    
+    return !fs.fullscreen_active;
+}
+
+void xwin_close_fullscreen_check(void) {
+    if (fs.d) {
+        XCloseDisplay(fs.d);
+        XSetErrorHandler(fs.error_handler);
+        fs.d = NULL;
     }
-close:
-    if (data)
-        XFree(data);
-    if (should_close)
-        XCloseDisplay(d);
-    return ret;
 }
 
 /* Create string copy on stack with upcase chars */
@@ -342,7 +394,111 @@ static Drawable get_drawable(Display* d, Window w) {
     return p;
 }
 
+/* Persistent state for `xwin_copyglbg`. The image (and its shared memory segment) is only
+   reallocated when the window is resized, and uploads go through a pixel buffer object so
+   they do not block on the GPU. */
+static struct {
+    Display* d;
+    XImage* image;
+    XShmSegmentInfo shminfo;
+    bool shm;
+    int w, h;
+    GLuint pbo;
+    GLuint tex;        /* texture that storage was allocated for */
+    int tex_w, tex_h;
+} bg;
+
+static void bg_free_image(void) {
+    if (!bg.image)
+        return;
+    if (bg.shm) {
+        XShmDetach(bg.d, &bg.shminfo);
+        shmdt(bg.shminfo.shmaddr);
+    }
+    XDestroyImage(bg.image);
+    bg.image = NULL;
+}
+
+/* Obtain section of root pixmap into the persistent image */
+static XImage* bg_capture(Display* d, Drawable src, int x, int y, int w, int h) {
+    if (d != bg.d || w != bg.w || h != bg.h) {
+        bg_free_image();
+        bg.d   = d;
+        bg.w   = w;
+        bg.h   = h;
+        bg.shm = XShmQueryExtension(d);
+        if (bg.shm) {
+            bg.image = XShmCreateImage(d, DefaultVisual(d, DefaultScreen(d)),
+                                       DefaultDepth(d, DefaultScreen(d)), ZPixmap, NULL,
+                                       &bg.shminfo, (unsigned int) w, (unsigned int) h);
+            if ((bg.shminfo.shmid = shmget(IPC_PRIVATE, bg.image->bytes_per_line * bg.image->height,
+                                           IPC_CREAT | 0777)) == -1) {
+                fprintf(stderr, "shmget() failed: %s\n", strerror(errno));
+                glava_abort();
+            }
+            bg.shminfo.shmaddr  = bg.image->data = shmat(bg.shminfo.shmid, 0, 0);
+            bg.shminfo.readOnly = false;
+            XShmAttach(d, &bg.shminfo);
+            /* Once the server has attached, the segment can be marked for removal so it is
+               released even if we exit abnormally */
+            XSync(d, False);
+            shmctl(bg.shminfo.shmid, IPC_RMID, NULL);
+        }
+    }
+    if (bg.shm) {
+        XShmGetImage(d, src, bg.image, x, y, AllPlanes);
+    } else if (bg.image) {
+        XGetSubImage(d, src, x, y, (unsigned int) w, (unsigned int) h,
+                     AllPlanes, ZPixmap, bg.image, 0, 0);
+    } else {
+        bg.image = XGetImage(d, src, x, y, (unsigned int) w, (unsigned int) h,
+                             AllPlanes, ZPixmap);
+    }
+    return bg.image;
+}
+
+void xwin_freeglbg(void) {
+    bg_free_image();
+    if (bg.pbo)
+        glDeleteBuffers(1, &bg.pbo);
+    bg = (typeof(bg)) { .d = NULL };
+}
+
+/* Bind the root background pixmap directly to a texture if the backend supports it, returning
+   0 otherwise. Window coordinates map to texels with `offset + (x, flip * y)`. */
+unsigned int xwin_bindglbg(struct glava_renderer* rd, int offset[2], int* flip) {
+    struct gl_wcb* wcb = rd_get_wcb(rd);
+    if (!wcb->get_x11_display)
+        return 0;
+    void* impl = rd_get_impl_window(rd);
+    Display* d = wcb->get_x11_display();
+    Drawable src = get_drawable(d, DefaultRootWindow(d));
+    if (src == DefaultRootWindow(d))
+        return 0; /* no background pixmap */
+    
+    int x, y, w, h, pw, ph;
+    bool inverted;
+    GLuint texture = wcb->bind_pixmap(impl, src, &pw, &ph, &inverted);
+    if (!texture)
+        return 0;
+    
+    wcb->get_fbsize(impl, &w, &h);
+    wcb->get_pos(impl, &x, &y);
+    offset[0] = x;
+    if (inverted) {
+        /* first row is the top of the pixmap, like the copied image */
+        offset[1] = y + h;
+        *flip     = -1;
+    } else {
+        offset[1] = ph - y - h;
+        *flip     = 1;
+    }
+    return texture;
+}
+
 unsigned int xwin_copyglbg(struct glava_renderer* rd, unsigned int tex) {
+    if (!rd_get_wcb(rd)->get_x11_display)
+        return tex; /* there is no desktop to copy */
     GLuint texture = (GLuint) tex;
     if (!texture)
         glGenTextures(1, &texture);
@@ -356,32 +512,7 @@ unsigned int xwin_copyglbg(struct glava_renderer* rd, unsigned int tex) {
     XColor c;
     Display* d = rd_get_wcb(rd)->get_x11_display();
     Drawable src = get_drawable(d, DefaultRootWindow(d));
-    bool use_shm = XShmQueryExtension(d);
-    
-    /* Obtain section of root pixmap */
-    
-    XShmSegmentInfo shminfo;
-    Visual* visual = DefaultVisual(d, DefaultScreen(d));
-    XVisualInfo match = { .visualid = XVisualIDFromVisual(visual) };
-    int nret;
-    XVisualInfo* info = XGetVisualInfo(d, VisualIDMask, &match, &nret);
-    XImage* image;
-    if (use_shm) {
-        image = XShmCreateImage(d, visual, info->depth, ZPixmap, NULL,
-                                &shminfo, (unsigned int) w, (unsigned int) h);
-        if ((shminfo.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height,
-                                    IPC_CREAT | 0777)) == -1) {
-            fprintf(stderr, "shmget() failed: %s\n", strerror(errno));
-            glava_abort();
-        }
-        shminfo.shmaddr = image->data = shmat(shminfo.shmid, 0, 0);
-        shminfo.readOnly = false;
-        XShmAttach(d, &shminfo);
-        XShmGetImage(d, src, image, x, y, AllPlanes);
-    } else {
-        image = XGetImage(d, src, x, y, (unsigned int) w, (unsigned int) h,
-                          AllPlanes, ZPixmap);
-    }
+    XImage* image = bg_capture(d, src, x, y, w, h);
 
     /* Try to convert pixel bit depth to OpenGL storage format. The following formats\
        will need intermediate conversion before OpenGL can accept the data:
@@ -448,25 +579,33 @@ unsigned int xwin_copyglbg(struct glava_renderer* rd, unsigned int tex) {
         } else {
             /* Use image data directly. The alpha value is garbage/unassigned data, but
                we need to read it because X11 keeps pixel data aligned */
-            buf = (uint8_t*) image->data;
+            GLsizeiptr sz = (GLsizeiptr) image->bytes_per_line * image->height;
+            if (!bg.pbo)
+                glGenBuffers(1, &bg.pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bg.pbo);
+            /* Orphan the last upload, so we never wait for the GPU to finish reading it */
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, sz, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, sz, image->data);
             /* Data could be 2, 4, or 8 byte aligned, the RGBA format and type (depth)
                already ensures reads will be properly aligned across scanlines */
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, image->bytes_per_line / (image->bits_per_pixel / 8));
             GLenum format = image->bitmap_bit_order == LSBFirst ?
                 (!aligned ? GL_BGRA : GL_BGR) :
                 (!aligned ? GL_RGBA : GL_RGB);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, format, type, buf);
+            /* Texture storage is only reallocated when resized */
+            if (texture != bg.tex || w != bg.tex_w || h != bg.tex_h) {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, format, type, NULL);
+                bg.tex   = texture;
+                bg.tex_w = w;
+                bg.tex_h = h;
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, format, type, NULL);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4); /* restore default */
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
         }
     }
-    if (use_shm) {
-        XShmDetach(d, &shminfo);
-        shmdt(shminfo.shmaddr);
-        shmctl(shminfo.shmid, IPC_RMID, NULL);
-    }
-
-    if (image) XDestroyImage(image);
-    XFree(info);
     
     return texture;
 }
@@ -3,28 +3,18 @@ in vec4 gl_FragCoord;
 #request uniform "screen" screen
 uniform ivec2 screen;
 
-#request uniform "audio_sz" audio_sz
-uniform int audio_sz;
-
 #include "@bars.glsl"
 #include ":bars.glsl"
 
-#request uniform "audio_l" audio_l
-#request transform audio_l "window"
-#request transform audio_l "fft"
-#request transform audio_l "gravity"
-#request transform audio_l "avg"
-uniform sampler1D audio_l;
+/* Bar magnitudes are computed once per column, see `column.frag` */
+#request column "column.frag"
+#request uniform "column" column
+uniform sampler2D column;
 
-#request uniform "audio_r" audio_r
-#request transform audio_r "window"
-#request transform audio_r "fft"
-#request transform audio_r "gravity"
-#request transform audio_r "avg"
-uniform sampler1D audio_r;
+/* Only draw quads covering each bar, see `1.vert` */
+#request instances "1.vert" 0
 
 out vec4 fragment;
-#include ":util/smooth.glsl"
 
 #define TWOPI 6.28318530718
 #define PI 3.14159265359
@@ -65,53 +55,14 @@ void main() {
     float center =  section / 2.0F;         /* half section, distance to center             */
     float m = abs(mod(dx, section));        /* position in section                          */
     float md = m - center;                  /* position in section from center line         */
-    float nbars = floor((AREA_WIDTH * 0.5F) / section) * 2;
-    float p, s;
     if (md < ceil(float(BAR_WIDTH) / 2) && md >= -floor(float(BAR_WIDTH) / 2)) {  /* if not in gap */
-        s = dx / section;
-        p = (sign(s) == 1.0 ? ceil(s) : floor(s));
-        #if _CHANNELS == 2
-        p /= float(nbars / 2);
-        #else
-        p /= float(nbars);
-        #endif
-        p += sign(p) * ((0.5F + center) / AREA_WIDTH);                /* index center of bar position */
-        /* Apply smooth function and index texture */
-        #define smooth_f(tex, p) smooth_audio(tex, audio_sz, p)
-        float v;
+        vec4 c = texelFetch(column, ivec2(AREA_X, 0), 0);
         /* ignore out of bounds values */
-        if (p > 1.0F || p < -1.0F) {
+        if (c.g == 0.0F) {
             fragment = vec4(0, 0, 0, 0);
             return;
         }
-        /* handle user options and store result of indexing in 'v' */
-        if (p > 0.0F) {
-            #if DIRECTION == 1
-            p = 1.0F - p;
-            #endif
-            #if _CHANNELS == 1
-            v = smooth_f(audio_l, p);
-            #elif INVERT > 0 
-            v = smooth_f(audio_l, p);
-            #else
-            v = smooth_f(audio_r, p);
-            #endif
-        } else {
-            p = abs(p);
-            #if DIRECTION == 1
-            p = 1.0F - p;
-            #endif
-            #if _CHANNELS == 1
-            v = smooth_f(audio_l, p);
-            #elif INVERT > 0
-            v = smooth_f(audio_r, p);
-            #else
-            v = smooth_f(audio_l, p);
-            #endif
-        }
-        #undef smooth_f
-
-        v *= AMPLIFY;                    /* amplify result                                  */
+        float v = c.r;                   /* amplified result from the column pass           */
         if (d < v - BAR_OUTLINE_WIDTH) { /* if within range of the reported frequency, draw */
             #if BAR_OUTLINE_WIDTH > 0
             if (md < ceil(float(BAR_WIDTH) / 2) - BAR_OUTLINE_WIDTH && md >= -floor(float(BAR_WIDTH) / 2) + BAR_OUTLINE_WIDTH)
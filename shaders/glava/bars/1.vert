@@ -0,0 +1,74 @@
+/* Instanced geometry for `1.frag`; each instance covers a single bar, so only pixels that can
+   be part of a bar are shaded. The fragment shader still performs the exact per-pixel test. */
+
+layout(location = 0) in vec3 pos;
+
+/* requested in `1.frag` */
+uniform ivec2 screen;
+uniform sampler2D column;
+
+#include "@bars.glsl"
+#include ":bars.glsl"
+
+#if DISABLE_MONO == 1
+#define _CHANNELS 2
+#endif
+
+void main() {
+
+    #if MIRROR_YX == 0
+    #define AREA_WIDTH screen.x
+    #define AREA_HEIGHT screen.y
+    #else
+    #define AREA_WIDTH screen.y
+    #define AREA_HEIGHT screen.x
+    #endif
+
+    float section = BAR_WIDTH + BAR_GAP;    /* size of section for each bar (including gap) */
+    float center =  section / 2.0F;         /* half section, distance to center             */
+    
+    /* bar index for this instance, and the offset of `dx` (see `1.frag`) from `AREA_X` */
+    #if _CHANNELS == 2
+    int bar = gl_InstanceID - (int(AREA_WIDTH / 2) / (BAR_WIDTH + BAR_GAP)) - 1;
+    float offset = float(AREA_WIDTH / 2);
+    #else
+    int bar = gl_InstanceID;
+    float offset = 0.0F;
+    #endif
+    
+    /* bar bounds along the X axis, in the same space as `dx` */
+    float x0 = (bar * section) + center - floor(float(BAR_WIDTH) / 2);
+    float x1 = (bar * section) + center + ceil(float(BAR_WIDTH) / 2);
+    
+    /* bounds in area coordinates, and the first column covered by this bar */
+    #if _CHANNELS == 1 && INVERT == 1
+    float a0 = AREA_WIDTH - x1, a1 = AREA_WIDTH - x0;
+    int col = int(floor(a0 - 0.5F)) + 1;
+    #else
+    float a0 = x0 + offset, a1 = x1 + offset;
+    int col = int(ceil(a0 - 0.5F));
+    #endif
+    
+    vec4 c = texelFetch(column, ivec2(col, 0), 0);
+    if (col < 0 || col >= AREA_WIDTH || c.g == 0.0F) {
+        gl_Position = vec4(0.0F, 0.0F, 0.0F, 1.0F); /* degenerate, nothing to draw */
+        return;
+    }
+    
+    /* pad the quad by a pixel; pixels outside of the bar are discarded by `1.frag` */
+    float v = max(c.r, 0.0F) + 1.0F;
+    vec2 t = (pos.xy * 0.5F) + 0.5F;
+    float ax = mix(a0 - 1.0F, a1 + 1.0F, t.x);
+    #if FLIP == 0
+    float ay = mix(0.0F, v, t.y);
+    #else
+    float ay = mix(AREA_HEIGHT - v, AREA_HEIGHT, t.y);
+    #endif
+    
+    #if MIRROR_YX == 0
+    vec2 area = vec2(ax, ay);
+    #else
+    vec2 area = vec2(ay, ax);
+    #endif
+    gl_Position = vec4(((area / vec2(screen)) * 2.0F) - 1.0F, 0.0F, 1.0F);
+}
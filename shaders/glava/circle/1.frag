@@ -24,6 +24,9 @@ uniform sampler1D audio_l;
 #request transform audio_r "avg"
 uniform sampler1D audio_r;
 
+/* Only shade the area around the center that can be drawn to, see `1.vert` */
+#request bounds "1.vert"
+
 out vec4 fragment;
 
 #define TWOPI 6.28318530718
@@ -0,0 +1,20 @@
+/* Bounds for `1.frag`: a square around the center, covering the inner circle and the longest
+   bar that can be drawn with the current audio data. */
+
+#include ":util/bounds.glsl"
+
+/* requested in `1.frag` */
+uniform ivec2 screen;
+uniform sampler1D audio_l;
+uniform sampler1D audio_r;
+
+#include "@radial.glsl"
+#include ":radial.glsl"
+
+void main() {
+    vec2 center = vec2((screen.x / 2) - CENTER_OFFSET_X, (screen.y / 2) - CENTER_OFFSET_Y);
+    float r = C_RADIUS + (float(C_LINE) / 2.0F)
+        + (max(max_audio(audio_l), max_audio(audio_r)) * AMPLIFY)
+        + 2.0F; /* margin for pixel centers and aliasing */
+    emit_bounds(center - r, center + r, screen);
+}
@@ -119,10 +119,11 @@
    (`setsamplerate` and `setsamplesize`), or monitors that have
    high refresh rates.
    
-   This feature itself, however, will effect performance as it
-   will have to interpolate data every frame on the CPU. It will
-   automatically (and temporarily) disable itself if the update
-   rate is close to, or higher than the framerate:
+   Keyframes are kept on the GPU and blended with a small 1D
+   pass between updates, so the processed audio data is only
+   computed once per update. It will automatically (and
+   temporarily) disable itself if the update rate is close to,
+   or higher than the framerate:
    
    if (update_rate / frame_rate > 0.9) disable_interpolation;
    
@@ -134,6 +135,42 @@
    simply set to zero (or lower) to disable the frame limiter. */
 #request setframerate 0
 
+/* Frame time budget in milliseconds, or zero to disable. If the
+   average time taken by each frame exceeds this budget, quality
+   is reduced one step per second until it does not, in order:
+   
+   1. interpolation is disabled
+   2. the audio buffer scale (`setbufscale`) is doubled
+   3. stages rendering at a reduced size (`#request scale`) are
+      reduced further
+   4. the framerate is limited to half of the measured rate
+   
+   Steps are reverted once frames take less than 60% of the
+   budget for a few seconds. Frame time includes waiting for
+   vsync, so the budget should be above the refresh interval of
+   the display (ie. 16.7ms at 60Hz) if `setswap` is enabled. */
+#request setframebudget 0
+
+/* Rendering policies, which override the framerate, audio
+   buffer scale (see `setbufscale`) and interpolation settings
+   while the system is in one of the following states:
+   
+   "battery" - running on battery power, with no AC adapter
+   "load"    - the 1 minute load average per CPU exceeds the
+               value set with `setloadthreshold`
+   
+   If both states apply, the "load" policy is used. The system
+   state is checked every 5 seconds, and the settings in this
+   file are restored when no state applies. Arguments are the
+   state, followed by the framerate, buffer scale and whether
+   interpolation is allowed while the state applies. */
+// #request setpolicy "battery" 30 1 false
+// #request setpolicy "load" 30 2 false
+#request setloadthreshold 0
+
+/* Directory to read power supply state from */
+#request setpowersupplypath "/sys/class/power_supply"
+
 /* Suspends rendering if a fullscreen window is focused while
    GLava is still visible (ie. on another monitor). This prevents
    rendering from interfering with other graphically intensive
@@ -230,7 +267,7 @@
    performed on the data. Higher values are faster.
    
    This value can affect the output of various transformations,
-   since it applies (crude) averaging to the data when shrinking
-   the buffer. It is reccommended to use `setsamplerate` and
+   since the data is lowpass filtered when shrinking the buffer
+   (only new samples are filtered each update). It is reccommended to use `setsamplerate` and
    `setsamplesize` to improve performance or accuracy instead. */
 #request setbufscale 1
@@ -67,8 +67,9 @@
 #request setgravitystep 4.2
 
 /* Smoothing factor. Larger values mean more smoothing in the output,
-   however high values can be expensive to compute. Values are in
-   normalized width: [0.0, 1.0) */
+   however high values can be expensive to compute (unless a module
+   samples `audio_l_psum` / `audio_r_psum` with `smooth_audio_psum`).
+   Values are in normalized width: [0.0, 1.0) */
 #request setsmoothfactor 0.025
 
 /* Whether to use a separate pass for audio data while smoothing. On
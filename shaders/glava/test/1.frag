@@ -24,10 +24,19 @@ uniform sampler1D audio_l;
 #request transform audio_r "avg"
 uniform sampler1D audio_r;
 
+#request uniform "audio_l_psum" audio_l_psum
+uniform sampler1D audio_l_psum;
+
+#request instances "1.vert" 1
+
+/* Render at half size to assert that reduced size stages are sampled correctly */
+#request scale 2
+
 out vec4 fragment;
 
 void main() {
     float dummy_result0 = smooth_audio(audio_l, audio_sz, gl_FragCoord.x / float(screen.x));
     float dummy_result1 = smooth_audio(audio_r, audio_sz, gl_FragCoord.x / float(screen.x));
+    float dummy_result2 = smooth_audio_psum(audio_l_psum, audio_sz, gl_FragCoord.x / float(screen.x));
     fragment = vec4(1.0, 0, 0, float(1) / float(3));
 }
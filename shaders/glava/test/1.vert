@@ -0,0 +1,7 @@
+/* Single instance covering the whole screen, to assert that module vertex shaders work */
+
+layout(location = 0) in vec3 pos;
+
+void main() {
+    gl_Position = vec4(pos.x, pos.y, 0.0F, 1.0F);
+}
@@ -2,11 +2,20 @@
 
 in vec4 gl_FragCoord;
 
+#request uniform "screen" screen
+uniform ivec2 screen;
+
 #request uniform "prev" tex
 uniform sampler2D tex;    /* screen texture    */
 
+#request column "column.frag"
+#request uniform "column" column
+uniform sampler2D column; /* column texture    */
+
 out vec4 fragment; /* output */
 
 void main() {
-    fragment = texelFetch(tex, ivec2(gl_FragCoord.x, gl_FragCoord.y), 0);
+    /* `1.frag` is rendered at a reduced size, sample it with normalized coordinates */
+    fragment = texture(tex, gl_FragCoord.xy / vec2(screen))
+        * texelFetch(column, ivec2(gl_FragCoord.x, 0), 0).r;
 }
@@ -0,0 +1,7 @@
+/* Column pass for `2.frag`; a constant factor to assert that column stages are rendered and bound */
+
+out vec4 fragment;
+
+void main() {
+    fragment = vec4(1.0, 0, 0, 1.0);
+}
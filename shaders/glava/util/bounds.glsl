@@ -0,0 +1,25 @@
+#ifndef _BOUNDS_GLSL
+#define _BOUNDS_GLSL
+
+/* Helpers for `#request bounds` vertex shaders, which position a single quad over the area
+   that a stage can draw to. Fragments outside of the quad are never shaded, and keep the
+   clear color. */
+
+layout(location = 0) in vec3 pos;
+
+/* Largest value in an audio texture; `smooth_audio` never exceeds this */
+float max_audio(in sampler1D tex) {
+    float m = 0.0F;
+    int sz = textureSize(tex, 0);
+    for (int t = 0; t < sz; ++t)
+        m = max(m, texelFetch(tex, t, 0).r);
+    return m;
+}
+
+/* Cover the rectangle from `lo` to `hi`, in window coordinates */
+void emit_bounds(vec2 lo, vec2 hi, ivec2 screen) {
+    vec2 p = mix(lo, hi, (pos.xy * 0.5F) + 0.5F);
+    gl_Position = vec4(((p / vec2(screen)) * 2.0F) - 1.0F, 0.0F, 1.0F);
+}
+
+#endif
@@ -0,0 +1,12 @@
+uniform sampler1D t0; /* previous keyframe    */
+uniform sampler1D t1; /* most recent keyframe */
+uniform float factor;
+
+out vec4 fragment;
+in vec4 gl_FragCoord;
+
+/* Linear interpolation between two 1D keyframes */
+void main() {
+    int x = int(gl_FragCoord.x);
+    fragment.r = mix(texelFetch(t0, x, 0).r, texelFetch(t1, x, 0).r, factor);
+}
@@ -1,8 +1,10 @@
-
 #if _PREMULTIPLY_ALPHA == 0
 #error __disablestage
 #endif
 
+/* Applied to the output of the previous stage instead, if possible */
+#request fold "fragment.rgb *= fragment.a;"
+
 #request uniform "prev" tex
 uniform sampler2D tex;
 
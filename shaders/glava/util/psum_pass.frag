@@ -0,0 +1,14 @@
+uniform sampler1D tex;
+uniform int step;
+
+out vec4 fragment;
+in vec4 gl_FragCoord;
+
+/* Single step of an inclusive prefix sum (scan), see `smooth_audio_psum` */
+void main() {
+    int idx = int(gl_FragCoord.x);
+    float v = texelFetch(tex, idx, 0).r;
+    if (idx >= step)
+        v += texelFetch(tex, idx - step, 0).r;
+    fragment.r = v;
+}
@@ -63,6 +63,24 @@ float smooth_audio(in sampler1D tex, int tex_sz, highp float idx) {
     #endif
 }
 
+/* Variant of `smooth_audio` that takes a prefix sum texture (ie. `audio_l_psum`) and averages
+   the same sample range with two fetches, regardless of `_SMOOTH_FACTOR`. Values in the range
+   are weighted evenly, rather than with `ROUND_FORMULA`. */
+float smooth_audio_psum(in sampler1D psum, int tex_sz, highp float idx) {
+    #if _PRE_SMOOTHED_AUDIO < 1
+    int
+        smin = int(round(scale_audio(clamp(idx - _SMOOTH_FACTOR, 0, 1)) * tex_sz)),
+        smax = int(round(scale_audio(clamp(idx + _SMOOTH_FACTOR, 0, 1)) * tex_sz));
+    smin = clamp(smin, 0, tex_sz - 1);
+    smax = clamp(smax, smin, tex_sz - 1);
+    #else
+    int smin = clamp(int(round(idx * tex_sz)), 0, tex_sz - 1), smax = smin;
+    #endif
+    float upper = texelFetch(psum, smax, 0).r;
+    float lower = smin > 0 ? texelFetch(psum, smin - 1, 0).r : 0.0F;
+    return (upper - lower) / float((smax - smin) + 1);
+}
+
 /* Applies the audio smooth sampling function three times to the adjacent values */
 float smooth_audio_adj(in sampler1D tex, int tex_sz, highp float idx, highp float pixel) {
     float